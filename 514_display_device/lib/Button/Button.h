@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_attr.h>
+#define BUTTON_ISR_ATTR IRAM_ATTR
+#else
+#define BUTTON_ISR_ATTR
+#endif
+
+// **Debounced Button with Auto-Repeat**
+// The GPIO interrupt calls edge() with the pin level and a timestamp; a task
+// calls update() to turn those edges into presses. A press is accepted on
+// its first edge (leading-edge debounce), a release only once the pin has
+// stayed released for debounceUs. Holding the button repeats the press,
+// getting faster on every repeat. Times are microseconds, so the logic runs
+// the same with micros() on the device or a fake clock on a host.
+class Button {
+public:
+    static const uint32_t NEVER = 0xFFFFFFFF;
+
+    struct Config {
+        uint32_t debounceUs;           // Release must be stable this long
+        uint32_t repeatDelayUs;        // Hold time before the first repeat
+        uint32_t repeatIntervalUs;     // Interval between the first repeats
+        uint32_t repeatMinIntervalUs;  // Fastest repeat interval
+        uint32_t repeatAccelPercent;   // Each interval is this % of the last
+    };
+
+    explicit Button(const Config& config)
+        : config_(config), rawPressed_(false), pressLatched_(false), lastEdgeUs_(0), pressEdgeUs_(0),
+          pressed_(false), pressUs_(0), nextRepeatUs_(0), repeatIntervalUs_(0) {}
+
+    // Call from the pin interrupt with the level after the edge
+    void BUTTON_ISR_ATTR edge(bool pressed, uint32_t nowUs) {
+        lastEdgeUs_ = nowUs;
+        rawPressed_ = pressed;
+        if (pressed && !pressLatched_) {
+            pressEdgeUs_ = nowUs;
+            pressLatched_ = true;  // Keep taps shorter than a poll
+        }
+    }
+
+    // Returns 1 when a press or a repeat should be applied, 0 otherwise
+    int update(uint32_t nowUs) {
+        uint32_t lastEdge = lastEdgeUs_;
+        bool raw = rawPressed_;
+
+        if (!pressed_) {
+            if (!raw && !pressLatched_) return 0;
+            pressLatched_ = false;
+            pressed_ = true;
+            pressUs_ = pressEdgeUs_;
+            repeatIntervalUs_ = config_.repeatIntervalUs;
+            nextRepeatUs_ = pressUs_ + config_.repeatDelayUs;
+            return 1;
+        }
+
+        if (!raw) {
+            if (nowUs - lastEdge >= config_.debounceUs) {
+                pressed_ = false;
+                pressLatched_ = false;
+            }
+            return 0;
+        }
+
+        pressLatched_ = false;  // Bounces while held are not new presses
+        if (before(nowUs, nextRepeatUs_)) return 0;
+
+        nextRepeatUs_ += repeatIntervalUs_;
+        if (before(nextRepeatUs_, nowUs)) nextRepeatUs_ = nowUs + repeatIntervalUs_;
+        repeatIntervalUs_ = repeatIntervalUs_ * config_.repeatAccelPercent / 100;
+        if (repeatIntervalUs_ < config_.repeatMinIntervalUs) {
+            repeatIntervalUs_ = config_.repeatMinIntervalUs;
+        }
+        return 1;
+    }
+
+    // Microseconds until update() has more to do, NEVER while idle
+    uint32_t timeUntilUpdateUs(uint32_t nowUs) const {
+        if (!pressed_) return rawPressed_ || pressLatched_ ? 0 : NEVER;
+        if (!rawPressed_) return remaining(lastEdgeUs_ + config_.debounceUs, nowUs);
+        return remaining(nextRepeatUs_, nowUs);
+    }
+
+    bool isPressed() const { return pressed_; }
+    uint32_t pressTimeUs() const { return pressUs_; }  // Edge time of the last press
+
+private:
+    // Wrap-safe "a is earlier than b"
+    static bool before(uint32_t a, uint32_t b) { return (int32_t)(a - b) < 0; }
+
+    static uint32_t remaining(uint32_t deadline, uint32_t nowUs) {
+        return before(nowUs, deadline) ? deadline - nowUs : 0;
+    }
+
+    Config config_;
+
+    // Written by the interrupt
+    volatile bool rawPressed_;
+    volatile bool pressLatched_;
+    volatile uint32_t lastEdgeUs_;
+    volatile uint32_t pressEdgeUs_;  // First press edge since the last accepted press
+
+    // Debounced state, owned by the task
+    bool pressed_;
+    uint32_t pressUs_;
+    uint32_t nextRepeatUs_;
+    uint32_t repeatIntervalUs_;
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// **Display Back End**
+// Moves a frame to the panel. The SSD1306 I2C back end lives in main.cpp;
+// a host build can pass a back end that just captures the bytes.
+class DisplayBackend {
+public:
+    virtual ~DisplayBackend() {}
+    virtual void beginFrame() = 0;                               // Address the whole panel
+    virtual void writeData(const uint8_t* data, size_t length) = 0;  // Next bytes of the frame
+};
+
+// **Double-Buffered Frame Flusher**
+// Rendering happens in the back buffer (the GFX buffer). submit() copies a
+// finished frame into the front buffer and pump() sends it one chunk at a
+// time, so other tasks can run between chunks. A frame submitted during a
+// flush is sent once the current one completes; frames submitted in the
+// meantime are coalesced into it.
+template <size_t FrameBytes>
+class FrameFlusher {
+public:
+    typedef uint32_t (*ClockFunction)();  // Free running microseconds
+
+    struct Stats {
+        uint32_t framesSubmitted;
+        uint32_t framesFlushed;
+        uint32_t framesCoalesced;  // Replaced before they were sent
+        uint32_t lastFlushUs;      // First chunk to last chunk, wall time
+        uint32_t maxFlushUs;
+        uint32_t lastBusUs;        // Time spent inside the back end
+        uint32_t maxChunkUs;       // Longest single chunk
+    };
+
+    FrameFlusher(DisplayBackend& backend, size_t chunkBytes, ClockFunction clock)
+        : backend_(&backend), chunkBytes_(chunkBytes), clock_(clock), back_(NULL),
+          offset_(0), flushing_(false), pending_(false), flushStartUs_(0), busUs_(0), stats_() {}
+
+    // Hand over a finished frame. The buffer must stay valid (it is read
+    // again if a flush is already running) but may be drawn into again.
+    void submit(const uint8_t* backBuffer) {
+        stats_.framesSubmitted++;
+        back_ = backBuffer;
+        if (flushing_) {
+            if (pending_) stats_.framesCoalesced++;
+            pending_ = true;
+            return;
+        }
+        startFlush();
+    }
+
+    // Send the next chunk; returns true while there is more to send
+    bool pump() {
+        if (!flushing_) return false;
+
+        uint32_t start = clock_();
+        if (offset_ == 0) {
+            flushStartUs_ = start;
+            busUs_ = 0;
+            backend_->beginFrame();
+        }
+        size_t length = FrameBytes - offset_;
+        if (length > chunkBytes_) length = chunkBytes_;
+        backend_->writeData(front_ + offset_, length);
+        offset_ += length;
+
+        uint32_t end = clock_();
+        uint32_t chunkUs = end - start;
+        busUs_ += chunkUs;
+        if (chunkUs > stats_.maxChunkUs) stats_.maxChunkUs = chunkUs;
+
+        if (offset_ < FrameBytes) return true;
+
+        stats_.framesFlushed++;
+        stats_.lastFlushUs = end - flushStartUs_;
+        stats_.lastBusUs = busUs_;
+        if (stats_.lastFlushUs > stats_.maxFlushUs) stats_.maxFlushUs = stats_.lastFlushUs;
+        flushing_ = false;
+
+        if (pending_) {
+            pending_ = false;
+            startFlush();
+            return true;
+        }
+        return false;
+    }
+
+    bool isFlushing() const { return flushing_; }
+    const uint8_t* frontBuffer() const { return front_; }
+    const Stats& stats() const { return stats_; }
+    void resetStats() { stats_ = Stats(); }
+
+    // Swap the back end, e.g. for a capture stub
+    void setBackend(DisplayBackend& backend) { backend_ = &backend; }
+
+private:
+    void startFlush() {
+        memcpy(front_, back_, FrameBytes);
+        offset_ = 0;
+        flushing_ = true;
+    }
+
+    DisplayBackend* backend_;
+    size_t chunkBytes_;
+    ClockFunction clock_;
+    const uint8_t* back_;
+    uint8_t front_[FrameBytes];
+    size_t offset_;
+    bool flushing_;
+    bool pending_;
+    uint32_t flushStartUs_;
+    uint32_t busUs_;
+    Stats stats_;
+};
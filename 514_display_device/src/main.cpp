@@ -7,27 +7,33 @@
 #include <BLEClient.h>
 #include <BLEScan.h>
 #include <BLEAdvertisedDevice.h>
+#include <esp_rom_sys.h>
+#include <new>
+#include <LoopScheduler.h>
+#include <Button.h>
+#include <FrameFlusher.h>
+#include <HardwareProfile.h>
+#include <LinkStats.h>
 
-// **OLED Configuration**
-#define SCREEN_WIDTH 128
-#define SCREEN_HEIGHT 64
-#define OLED_RESET    -1  
-#define I2C_ADDRESS   0x3C
+// **Hardware Profile** - pick the parts for this build variant here
+typedef DisplayProfile<XiaoDisplayBoard, Ssd1306_128x64, GaugeStepper, ShowerGoal> Profile;
+typedef Profile::board Board;
+typedef Profile::panel Panel;
+typedef Profile::gauge Gauge;
+typedef GoalTable<Profile> Goals;
+typedef WaterTrackerBle Ble;
 
-#define SDA_PIN 6
-#define SCL_PIN 7
+// **OLED Configuration**
+const size_t flushChunkBytes = 64;  // Bytes per I2C transfer (Wire buffer is 128)
 
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
+// Keep the bus at the panel's clock during and after the library's own transfers
+Adafruit_SSD1306 display(Panel::width, Panel::height, &Wire, Panel::resetPin, Panel::i2cClock, Panel::i2cClock);
 
 // **Stepper Motor Configuration**
-#define MOTOR_PIN_1 0  
-#define MOTOR_PIN_2 1  
-#define MOTOR_PIN_3 2  
-#define MOTOR_PIN_4 3  
-
 int stepPosition = 0;    // Tracks current stepper position
-const int maxSteps = 160; // Maximum stepper position
-const int minSteps = 0;   // Minimum stepper position
+int stepperTarget = 0;    // Position the stepper task is moving toward
+int stepperPhase = 0;     // Coil phase within the current step (0-3)
+int stepperDirection = 0; // Direction of the current step (+1/-1, 0 idle)
 
 // **Stepper Motor Step Sequence**
 const int stepSequence[4][4] = {
@@ -39,40 +45,196 @@ const int stepSequence[4][4] = {
 
 // **Water Consumption Variables**
 float numerator = 0.0;    // Water consumed
-float denominator = 30.0; // Water consumption goal
+int goalIndex = Profile::defaultGoalIndex;   // Position in the goal tables
+float denominator = Goals::liters[goalIndex]; // Water consumption goal
 float initialOffset = 0.0; // Offset to subtract from received values
 bool firstDataReceived = false; // Flag to track if we've received initial data
 
-// **Button Pins**
-#define BUTTON_UP 8
-#define BUTTON_DOWN 9
-
-// **LED Pin**
-#define LED_PIN 10  
+// Debounce and hold-to-repeat timing (microseconds)
+const Button::Config buttonConfig = {
+    20000,   // Release must be stable for 20 ms
+    400000,  // Hold 400 ms before repeating
+    200000,  // Interval between the first repeats
+    40000,   // Repeat no faster than every 40 ms
+    80       // Each repeat comes 20% sooner
+};
+Button buttonUp(buttonConfig);
+Button buttonDown(buttonConfig);
 
 // **BLE UUIDs**
-#define SERVICE_UUID        "6ffd810a-1f60-43df-aa2f-cb68a815285f"
-#define CHARACTERISTIC_UUID "7ca0eada-bb21-4d31-8c72-e52221ea4409"
-
-static BLEUUID serviceUUID(SERVICE_UUID);
-static BLEUUID charUUID(CHARACTERISTIC_UUID);
+static BLEUUID serviceUUID(Ble::serviceUuid());
+static BLEUUID charUUID(Ble::dataUuid());
+static BLEUUID syncCharUUID(Ble::syncUuid());
+static BLERemoteCharacteristic* pSyncCharacteristic = NULL;
 static boolean doConnect = false;
 static boolean connected = false;
 static boolean doScan = false;
-static BLEAdvertisedDevice* myDevice;
+static volatile boolean scanning = false;
+static esp_bd_addr_t myDeviceAddress;  // Last scan match, kept instead of a device copy
+static esp_ble_addr_type_t myDeviceAddressType = BLE_ADDR_TYPE_PUBLIC;
 BLEClient* pClient = NULL;
 BLEScan* pBLEScan = NULL;
 
+// **Link Statistics** - clock sync, packet loss and latency
+LinkStats linkStats;
+const unsigned long syncInterval = 10000; // Clock sync interval (ms)
+
+// **Heap Instrumentation**
+// Build with -DHEAP_ASSERT_NO_ALLOC (and the malloc wraps in platformio.ini)
+// to abort on any heap allocation made inside a HeapGuard scope once setup()
+// has finished. loop() guards every task, and the BLE callbacks and connect
+// task guard themselves. HeapExempt scopes mark the BLE library calls that
+// allocate by design: scan start and stop, GATT connect and discovery, and
+// characteristic writes.
+static bool heapLocked = false;          // Set at the end of setup()
+static thread_local int heapGuardDepth = 0;
+static thread_local const char* heapGuardName = "";
+static unsigned long connectCount = 0;   // Successful connections since boot
+const unsigned long heapLogInterval = 60000; // Heap stats log interval (ms)
+
+// Marks a steady-state code path that must not touch the heap
+struct HeapGuard {
+    const char* prevName;
+    HeapGuard(const char* name) : prevName(heapGuardName) {
+        heapGuardName = name;
+        heapGuardDepth++;
+    }
+    ~HeapGuard() {
+        heapGuardDepth--;
+        heapGuardName = prevName;
+    }
+};
+
+// Marks a library call inside a guarded path that is allowed to allocate
+struct HeapExempt {
+    int prevDepth;
+    HeapExempt() : prevDepth(heapGuardDepth) { heapGuardDepth = 0; }
+    ~HeapExempt() { heapGuardDepth = prevDepth; }
+};
+
+#ifdef HEAP_ASSERT_NO_ALLOC
+// Also link with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc so C
+// allocations (BLE stack, String, printf) are checked, not just operator new
+extern "C" void* __real_malloc(size_t size);
+extern "C" void* __real_calloc(size_t count, size_t size);
+extern "C" void* __real_realloc(void* p, size_t size);
+
+static void assertHeapAllowed(size_t size) {
+    if (heapLocked && heapGuardDepth > 0) {
+        // Serial may not be safe here, use the ROM printer instead
+        esp_rom_printf("HEAP ASSERT: %u byte allocation in '%s'\n", (unsigned)size, heapGuardName);
+        abort();
+    }
+}
+
+static void* checkedAlloc(size_t size) {
+    assertHeapAllowed(size);
+    return __real_malloc(size);
+}
+
+extern "C" void* __wrap_malloc(size_t size) { return checkedAlloc(size); }
+extern "C" void* __wrap_calloc(size_t count, size_t size) {
+    assertHeapAllowed(count * size);
+    return __real_calloc(count, size);
+}
+extern "C" void* __wrap_realloc(void* p, size_t size) {
+    assertHeapAllowed(size);
+    return __real_realloc(p, size);
+}
+
+static void* checkedNew(size_t size) {
+    void* p = checkedAlloc(size);
+    if (p == NULL) abort();  // Plain new must never return NULL
+    return p;
+}
+
+void* operator new(size_t size) { return checkedNew(size); }
+void* operator new[](size_t size) { return checkedNew(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return checkedAlloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return checkedAlloc(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+#endif
+
+// **Task Scheduler**
+LoopScheduler scheduler;
+
+int buttonTask = Scheduler::NO_TASK;
+int displayTask = Scheduler::NO_TASK;
+int gaugeTask = Scheduler::NO_TASK;
+int stepperTask = Scheduler::NO_TASK;
+int bleTask = Scheduler::NO_TASK;
+int syncTask = Scheduler::NO_TASK;
+int consoleTask = Scheduler::NO_TASK;
+int heapTask = Scheduler::NO_TASK;
+int flushTask = Scheduler::NO_TASK;
+
+// **BLE Connect Task** - connecting and GATT discovery block for seconds,
+// so they run on their own FreeRTOS task which signals the ble task when done
+const uint32_t connectStackBytes = 6144;  // Stack depth is in bytes on the ESP32
+static StackType_t connectStack[connectStackBytes];
+static StaticTask_t connectTaskBuffer;
+TaskHandle_t connectTaskHandle = NULL;
+static volatile boolean connectBusy = false;    // Set by the ble task, cleared when done
+static volatile boolean connectResult = false;
+static boolean connectStarted = false;          // ble task still has to read the result
+static uint32_t connectStartMs = 0;
+
+// **SSD1306 Back End** - send frame bytes straight over I2C
+class Ssd1306I2cBackend : public DisplayBackend {
+public:
+    void beginFrame() {
+        // Horizontal addressing is set up by display.begin()
+        Wire.beginTransmission(Panel::i2cAddress);
+        Wire.write((uint8_t)0x00);  // Command stream
+        Wire.write((uint8_t)SSD1306_PAGEADDR);
+        Wire.write((uint8_t)0);
+        Wire.write((uint8_t)0xFF);
+        Wire.write((uint8_t)SSD1306_COLUMNADDR);
+        Wire.write((uint8_t)0);
+        Wire.write((uint8_t)(Panel::width - 1));
+        Wire.endTransmission();
+    }
+
+    void writeData(const uint8_t* data, size_t length) {
+        Wire.beginTransmission(Panel::i2cAddress);
+        Wire.write((uint8_t)0x40);  // Data stream
+        Wire.write(data, length);
+        Wire.endTransmission();
+    }
+};
+
+// Rendering goes into the GFX buffer, the flusher sends a copy of it
+Ssd1306I2cBackend ssd1306Backend;
+FrameFlusher<Profile::frameBytes> frameFlusher(ssd1306Backend, flushChunkBytes, LoopScheduler::clock);
+uint32_t lastFrameUs = 0;  // Time to render the last frame
+uint32_t maxFrameUs = 0;
+
 // **Function Prototypes**
-void resetStepper();
 void resetStepperToZero();
 void moveStepperToPosition(int targetStep);
-void moveStepperForward(int steps = 1);
 void moveStepperBackward(int steps = 1);
 void updateDisplay();
 void resetVariables();
 bool connectToServer();
+bool openServer();
 void handleButtonPress();
+void logHeapStats(const char* tag);
+void sendSyncRequest();
+void dumpLinkStats();
+void dumpFrameStats();
+void flushDisplay();
+void runStepper();
+void updateGauge();
+void refreshDisplay();
+void manageBLE();
+void connectTaskMain(void*);
+void runConnect();
+void runClockSync();
+void handleSerialCommands();
+void logHeapTask();
 
 // Reset all variables to starting values
 void resetVariables() {
@@ -80,29 +242,70 @@ void resetVariables() {
     initialOffset = 0.0;     // Clear the offset
     numerator = 0.0;         // Reset water consumption
     firstDataReceived = false; // Reset first data flag
-    updateDisplay();         // Update the display to show zero
+    scheduler.signalFromTask(displayTask); // Update the display to show zero
+}
+
+// Log free heap, low-water mark and largest free block
+void logHeapStats(const char* tag) {
+    Serial.print("🧠 Heap [");
+    Serial.print(tag);
+    Serial.print("] free: ");
+    Serial.print(ESP.getFreeHeap());
+    Serial.print(" B, min free: ");
+    Serial.print(ESP.getMinFreeHeap());
+    Serial.print(" B, largest block: ");
+    Serial.print(ESP.getMaxAllocHeap());
+    Serial.print(" B, connects: ");
+    Serial.println(connectCount);
 }
 
 // **BLE Client Callback**
 class MyClientCallback : public BLEClientCallbacks {
-    void onConnect(BLEClient* pClient) { 
+    void onConnect(BLEClient*) { 
+        HeapGuard guard("onConnect");
         connected = true; 
         Serial.println("✅ Connected to BLE Server!");
     }
     
-    void onDisconnect(BLEClient* pClient) { 
+    void onDisconnect(BLEClient*) { 
+        HeapGuard guard("onDisconnect");
         connected = false; 
+        pSyncCharacteristic = NULL;
         Serial.println("❌ Disconnected from BLE Server!");
         // Reset variables when disconnected
         resetVariables();
         doScan = true;  // Restart scanning when disconnected
+        scheduler.signalFromTask(bleTask);
     }
 };
 
 // **BLE Scan Callback**
 class MyAdvertisedDeviceCallbacks: public BLEAdvertisedDeviceCallbacks {
     void onResult(BLEAdvertisedDevice advertisedDevice) {
-        // Print basic device info
+        HeapGuard guard("onResult");
+        bool ourDevice;
+        {
+            // The device's getters and UUID compares return std::string copies
+            HeapExempt exempt;
+            printAdvertisedDevice(advertisedDevice);
+            ourDevice = advertisedDevice.haveServiceUUID() && advertisedDevice.isAdvertisingService(serviceUUID);
+            if (ourDevice) BLEDevice::getScan()->stop();
+        }
+
+        // Connect if it's our device
+        if (ourDevice) {
+            memcpy(myDeviceAddress, *advertisedDevice.getAddress().getNative(), ESP_BD_ADDR_LEN);
+            myDeviceAddressType = advertisedDevice.getAddressType();
+            doConnect = true;
+            doScan = false;
+            scanning = false;
+            scheduler.signalFromTask(bleTask);
+            Serial.println("🎯 Found our water tracker device! Connecting...");
+        }
+    }
+
+    // Print basic device info
+    static void printAdvertisedDevice(BLEAdvertisedDevice& advertisedDevice) {
         Serial.print("🔍 BLE Device found: ");
         Serial.print("Name: \"");
         Serial.print(advertisedDevice.getName().c_str());
@@ -137,28 +340,89 @@ class MyAdvertisedDeviceCallbacks: public BLEAdvertisedDeviceCallbacks {
         }
         
         Serial.println();
-        
-        // Connect if it's our device
-        if (advertisedDevice.haveServiceUUID() && advertisedDevice.isAdvertisingService(serviceUUID)) {
-            BLEDevice::getScan()->stop();
-            myDevice = new BLEAdvertisedDevice(advertisedDevice);
-            doConnect = true;
-            doScan = false;
-            Serial.println("🎯 Found our water tracker device! Connecting...");
-        }
     }
 };
 
+// Callback objects live in static storage for the life of the program
+static MyClientCallback clientCallback;
+static MyAdvertisedDeviceCallbacks advertisedDeviceCallbacks;
+
+// **Clock Sync and Link Statistics**
+// Send our time to the sensing device, which stamps it and notifies it back
+void sendSyncRequest() {
+    if (pSyncCharacteristic == NULL) return;
+
+    SyncPacket request = {};
+    request.t1 = micros();
+    HeapExempt exempt;  // The GATT write command is queued on the heap
+    pSyncCharacteristic->writeValue((uint8_t*)&request, sizeof(request), false);
+}
+
+// Sync reply: t1/t4 are our clock, t2/t3 the sensor's
+static void syncNotifyCallback(
+    BLERemoteCharacteristic*,
+    uint8_t* pData,
+    size_t length,
+    bool) {
+    HeapGuard guard("syncNotifyCallback");
+    uint32_t t4 = micros();
+    if (length != sizeof(SyncPacket)) return;
+
+    SyncPacket reply;
+    memcpy(&reply, pData, sizeof(reply));
+    linkStats.onSyncReply(reply, t4);
+}
+
+// Print link statistics (send 'h' over serial, 'r' to reset)
+void dumpLinkStats() {
+    Serial.println("\n📈 LINK STATISTICS 📈");
+    Serial.print("Clock synced: ");
+    const LinkStats::Stats& stats = linkStats.stats();
+    Serial.print(linkStats.clockSynced() ? "yes" : "no");
+    Serial.print(", offset: ");
+    Serial.print(linkStats.clockOffsetUs());
+    Serial.print(" us, best RTT: ");
+    Serial.print(linkStats.bestRttUs());
+    Serial.println(" us");
+
+    Serial.print("Packets: ");
+    Serial.print(stats.packetsReceived);
+    Serial.print(", lost: ");
+    Serial.print(stats.packetsLost);
+    Serial.print(" in ");
+    Serial.print(stats.gapEvents);
+    Serial.print(" gaps, sequence resets: ");
+    Serial.println(stats.sequenceResets);
+
+    Serial.print("Max latency: ");
+    Serial.print(stats.maxLatencyUs / 1000.0, 1);
+    Serial.println(" ms");
+    for (int i = 0; i < LinkStats::LATENCY_BUCKETS; i++) {
+        Serial.print("  ");
+        if (i < LinkStats::LATENCY_BUCKETS - 1) {
+            Serial.print("< ");
+            Serial.print(LinkStats::bucketLimitMs(i));
+        } else {
+            Serial.print(">= ");
+            Serial.print(LinkStats::bucketLimitMs(i - 1));
+        }
+        Serial.print(" ms: ");
+        Serial.println(stats.latencyHistogram[i]);
+    }
+}
+
 // **BLE Notification Callback**
 static void notifyCallback(
-    BLERemoteCharacteristic* pRemoteCharacteristic,
+    BLERemoteCharacteristic*,
     uint8_t* pData,
     size_t length,
-    bool isNotify) {
+    bool) {
+    HeapGuard guard("notifyCallback");
+    uint32_t receiveTime = micros();
 
     Serial.println("\n📥 BLE Notification Received! 📥");
     Serial.print("Characteristic UUID: ");
-    Serial.println(pRemoteCharacteristic->getUUID().toString().c_str());
+    Serial.println(Ble::dataUuid());  // Only registered on this characteristic
     Serial.print("Data Length: ");
     Serial.println(length);
 
@@ -188,40 +452,53 @@ static void notifyCallback(
     }
     Serial.println();
 
-    // Convert raw bytes to a string
-    String receivedData = "";
-    for (size_t i = 0; i < length; i++) {
-        receivedData += (char)pData[i];
-    }
+    float totalLiters = 0.0;
 
-    Serial.print("📝 String Representation: '");
-    Serial.print(receivedData);
-    Serial.println("'");
+    if (length == sizeof(DataPacket)) {
+        // Binary packet with sequence number and sensor timestamp
+        DataPacket packet;
+        memcpy(&packet, pData, sizeof(packet));
+        linkStats.onPacket(packet, receiveTime);
+        totalLiters = packet.totalLiters;
 
-    // Try to convert the received string to a float
-    float totalLiters = 0.0;
-    bool validData = true;
-    
-    // Basic validation to check if data is a valid number
-    for (size_t i = 0; i < receivedData.length(); i++) {
-        char c = receivedData.charAt(i);
-        if (!isdigit(c) && c != '.' && c != '-') {
-            validData = false;
-            Serial.print("Invalid character detected: '");
-            Serial.print(c);
-            Serial.print("' at position ");
-            Serial.println(i);
-            break;
-        }
-    }
-    
-    if (validData) {
-        totalLiters = atof(receivedData.c_str());
-        Serial.print("✅ Parsed as Number: ");
+        Serial.print("✅ Packet seq ");
+        Serial.print(packet.seq);
+        Serial.print(": ");
         Serial.println(totalLiters);
     } else {
-        Serial.println("⚠️ Invalid data format received! Could not parse as number.");
-        return;
+        // Plain text value from older sensing firmware
+        // Copy raw bytes into a fixed buffer (no heap)
+        char receivedData[32];
+        size_t receivedLength = length < sizeof(receivedData) - 1 ? length : sizeof(receivedData) - 1;
+        memcpy(receivedData, pData, receivedLength);
+        receivedData[receivedLength] = '\0';
+
+        Serial.print("📝 String Representation: '");
+        Serial.print(receivedData);
+        Serial.println("'");
+
+        // Basic validation to check if data is a valid number
+        bool validData = true;
+        for (size_t i = 0; i < receivedLength; i++) {
+            char c = receivedData[i];
+            if (!isdigit(c) && c != '.' && c != '-') {
+                validData = false;
+                Serial.print("Invalid character detected: '");
+                Serial.print(c);
+                Serial.print("' at position ");
+                Serial.println(i);
+                break;
+            }
+        }
+        
+        if (validData) {
+            totalLiters = atof(receivedData);
+            Serial.print("✅ Parsed as Number: ");
+            Serial.println(totalLiters);
+        } else {
+            Serial.println("⚠️ Invalid data format received! Could not parse as number.");
+            return;
+        }
     }
 
     if (totalLiters >= 0) {  
@@ -250,18 +527,8 @@ static void notifyCallback(
         Serial.print(denominator);
         Serial.println(" L");
 
-        // Calculate the stepper position based on the water consumption ratio
-        int targetStep = map(numerator * 10, 0, denominator * 10, minSteps, maxSteps); // Multiply by 10 for better precision
-        targetStep = constrain(targetStep, minSteps, maxSteps); 
-
-        Serial.print("🚀 Moving Stepper to Step: ");
-        Serial.print(targetStep);
-        Serial.print(" (from ");
-        Serial.print(stepPosition);
-        Serial.println(")");
-
-        moveStepperToPosition(targetStep);
-        updateDisplay();
+        // Gauge and display are updated from the loop, not the BLE task
+        scheduler.signalFromTask(gaugeTask);
     } else {
         Serial.println("⚠️ Failed to process BLE Data! Negative value received.");
     }
@@ -269,34 +536,36 @@ static void notifyCallback(
 
 // **BLE Connection Function**
 bool connectToServer() {
-    Serial.println("\n🔌 CONNECTING TO BLE SERVER 🔌");
-    Serial.print("Device Address: ");
-    Serial.println(myDevice->getAddress().toString().c_str());
-    Serial.print("Device Name: ");
-    Serial.println(myDevice->getName().c_str());
-    
-    // List all advertised services
-    Serial.println("Advertised Services:");
-    if (myDevice->haveServiceUUID()) {
-        for (int i = 0; i < myDevice->getServiceUUIDCount(); i++) {
-            Serial.print("  - ");
-            Serial.println(myDevice->getServiceUUID(i).toString().c_str());
-        }
-    } else {
-        Serial.println("  No services advertised");
-    }
+    HeapGuard guard("connect");
+    linkStats.startConnection();  // Before any notification can arrive
 
-    // Clean up previous client if it exists
-    if (pClient != NULL) {
-        delete pClient;
+    bool opened;
+    {
+        // GATT connect and discovery build the library's service and
+        // characteristic maps, and registering notifications allocates too
+        HeapExempt exempt;
+        opened = openServer();
     }
-    
-    pClient = BLEDevice::createClient();
-    pClient->setClientCallbacks(new MyClientCallback());
+    if (!opened) return false;
+
+    Serial.println("\n✅ BLE CONNECTION COMPLETE ✅");
+    connected = true;
+    connectCount++;
+    logHeapStats("connect");
+    scheduler.signalFromTask(syncTask);  // Runs on the connect task, so wake the loop
+    return true;
+}
+
+// Connect to the scan match and register for its notifications
+bool openServer() {
+    Serial.println("\n🔌 CONNECTING TO BLE SERVER 🔌");
+    Serial.print("Device Address: ");
+    Serial.println(BLEAddress(myDeviceAddress).toString().c_str());
 
+    // The client is created once in setup() and reused for every connection
     // Connect to the remote BLE Server
     Serial.println("Attempting connection...");
-    if (!pClient->connect(myDevice)) {
+    if (!pClient->connect(BLEAddress(myDeviceAddress), myDeviceAddressType)) {
         Serial.println("❌ Failed to connect to BLE server.");
         return false;
     }
@@ -368,7 +637,7 @@ bool connectToServer() {
         
         // Show bytes in hex for debugging
         Serial.print("Hex: ");
-        for (int i = 0; i < value.length(); i++) {
+        for (size_t i = 0; i < value.length(); i++) {
             Serial.print((uint8_t)value[i], HEX);
             Serial.print(" ");
         }
@@ -385,91 +654,109 @@ bool connectToServer() {
         Serial.println("❗ Characteristic does not support notifications");
     }
 
-    Serial.println("\n✅ BLE CONNECTION COMPLETE ✅");
-    connected = true;
+    // Clock sync characteristic (optional, older sensing firmware lacks it)
+    pSyncCharacteristic = pRemoteService->getCharacteristic(syncCharUUID);
+    if (pSyncCharacteristic != nullptr && pSyncCharacteristic->canNotify()) {
+        pSyncCharacteristic->registerForNotify(syncNotifyCallback);
+        Serial.println("✅ Clock sync available");
+    } else {
+        pSyncCharacteristic = NULL;
+        Serial.println("❗ Clock sync not supported, latency will not be measured");
+    }
     return true;
 }
 
-// **Initialize stepper to zero position - turns back 170 steps**
+// **Initialize stepper to zero position - drives back into the end stop**
 void resetStepperToZero() {
-    Serial.println("🔄 Initializing stepper motor - moving backward 170 steps");
-    digitalWrite(LED_PIN, HIGH);  // Turn on LED during reset
+    Serial.print("🔄 Initializing stepper motor - moving backward ");
+    Serial.print(Gauge::homeSteps);
+    Serial.println(" steps");
+    digitalWrite(Board::ledPin, HIGH);  // Turn on LED during reset
 
-    // Move backward 170 steps regardless of current position
-    for (int i = 0; i < 170; i++) {
+    // Move backward past the full sweep regardless of current position
+    for (int i = 0; i < Gauge::homeSteps; i++) {
         moveStepperBackward(1);
-        delay(10);  // Small delay between steps
+        delay(Gauge::phaseIntervalMs);  // Small delay between steps
     }
     
     // Reset position counter
-    stepPosition = 0;
+    stepPosition = Gauge::minSteps;
     
-    digitalWrite(LED_PIN, LOW);  // Turn off LED when done
+    digitalWrite(Board::ledPin, LOW);  // Turn off LED when done
     Serial.println("✅ Stepper reset complete");
 }
 
-// **Reset Stepper Based on Water Consumption Ratio**
-void resetStepper() {
-    Serial.println("Resetting stepper to match water consumed ratio...");
-    digitalWrite(LED_PIN, HIGH);
-
-    // Calculate target step based on current water ratio
-    int targetStep = map(numerator * 10, 0, denominator * 10, minSteps, maxSteps);
-    targetStep = constrain(targetStep, minSteps, maxSteps);
-    
-    moveStepperToPosition(targetStep); 
-
-    digitalWrite(LED_PIN, LOW);
-    updateDisplay();
-}
-
-// **Move Stepper to Specific Position**
+// **Move Stepper to Specific Position** - the stepper task does the moving
 void moveStepperToPosition(int targetStep) {
     Serial.print("🚀 Moving Stepper to Position: ");
     Serial.println(targetStep);
 
-    targetStep = constrain(targetStep, minSteps, maxSteps);
+    if (targetStep < Gauge::minSteps) targetStep = Gauge::minSteps;
+    if (targetStep > Gauge::maxSteps) targetStep = Gauge::maxSteps;
+    stepperTarget = targetStep;
+    scheduler.signal(stepperTask);
+}
 
-    // More efficient movement by calculating number of steps needed
-    int stepsToMove = targetStep - stepPosition;
-    
-    if (stepsToMove > 0) {
-        moveStepperForward(stepsToMove);
-    } else if (stepsToMove < 0) {
-        moveStepperBackward(abs(stepsToMove));
+// **Stepper Task** - drives one coil phase per run so nothing blocks
+void runStepper() {
+    if (stepperDirection == 0) {
+        if (stepPosition == stepperTarget) return;
+        stepperDirection = stepperTarget > stepPosition ? 1 : -1;
+        stepperPhase = 0;
+    }
+
+    int s = stepperDirection > 0 ? stepperPhase : 3 - stepperPhase;
+    digitalWrite(Board::motorPin1, stepSequence[s][0]);
+    digitalWrite(Board::motorPin2, stepSequence[s][1]);
+    digitalWrite(Board::motorPin3, stepSequence[s][2]);
+    digitalWrite(Board::motorPin4, stepSequence[s][3]);
+
+    // A full step is four phases
+    if (++stepperPhase == 4) {
+        stepPosition += stepperDirection;
+        stepperDirection = 0;
+    }
+
+    if (stepperDirection != 0 || stepPosition != stepperTarget) {
+        scheduler.runAfter(stepperTask, Gauge::phaseIntervalMs);
     }
-    
-    stepPosition = targetStep;
 }
 
-// **Stepper Motor Control Functions - Optimized for multi-step movement**
-void moveStepperForward(int steps) {
-    for (int i = 0; i < steps; i++) {
-        for (int step = 0; step < 4; step++) {
-            digitalWrite(MOTOR_PIN_1, stepSequence[step][0]);
-            digitalWrite(MOTOR_PIN_2, stepSequence[step][1]);
-            digitalWrite(MOTOR_PIN_3, stepSequence[step][2]);
-            digitalWrite(MOTOR_PIN_4, stepSequence[step][3]);
-            delay(10);
-        }
+// **Gauge Task** - move the needle to match the water consumption ratio
+void updateGauge() {
+    // Steps per liter for the current goal come from a compile-time table
+    int targetStep = Gauge::minSteps + (int)(numerator * Goals::gaugeStepsPerLiter[goalIndex]);
+    if (targetStep > Gauge::maxSteps) targetStep = Gauge::maxSteps;
+
+    if (targetStep != stepperTarget) {
+        Serial.print("🚀 Moving Stepper to Step: ");
+        Serial.print(targetStep);
+        Serial.print(" (from ");
+        Serial.print(stepPosition);
+        Serial.println(")");
+        moveStepperToPosition(targetStep);
     }
+    scheduler.signal(displayTask);
 }
 
+// **Blocking Backward Steps** - only used for homing in setup()
 void moveStepperBackward(int steps) {
     for (int i = 0; i < steps; i++) {
         for (int step = 0; step < 4; step++) {
             int s = 3 - step;
-            digitalWrite(MOTOR_PIN_1, stepSequence[s][0]);
-            digitalWrite(MOTOR_PIN_2, stepSequence[s][1]);
-            digitalWrite(MOTOR_PIN_3, stepSequence[s][2]);
-            digitalWrite(MOTOR_PIN_4, stepSequence[s][3]);
-            delay(10);
+            digitalWrite(Board::motorPin1, stepSequence[s][0]);
+            digitalWrite(Board::motorPin2, stepSequence[s][1]);
+            digitalWrite(Board::motorPin3, stepSequence[s][2]);
+            digitalWrite(Board::motorPin4, stepSequence[s][3]);
+            delay(Gauge::phaseIntervalMs);
         }
     }
 }
 
 // **Update OLED Display with Progress Bar**
 void updateDisplay() {
+    HeapGuard guard("updateDisplay");
+    uint32_t frameStart = micros();
     display.clearDisplay();
     
     // Title
@@ -480,7 +767,7 @@ void updateDisplay() {
     
     // Water values with decimals
     display.setTextSize(2);
-    display.setCursor(5, 16);
+    display.setCursor(Profile::valueX, Profile::valueY);
     
     // Format numbers with 1 decimal place
     char waterValue[16];
@@ -501,46 +788,81 @@ void updateDisplay() {
     display.print(trimmedGoal);
     display.println("L");
 
-    // Draw a progress bar
-    int barWidth = map(numerator * 10, 0, denominator * 10, 0, 108); // Multiply by 10 for better precision
-    barWidth = constrain(barWidth, 0, 108);
-    display.drawRect(10, 40, 108, 15, SSD1306_WHITE);
-    display.fillRect(10, 40, barWidth, 15, SSD1306_WHITE);
+    // Draw a progress bar, pixels per liter come from a compile-time table
+    int barWidth = (int)(numerator * Goals::barPixelsPerLiter[goalIndex]);
+    if (barWidth > Profile::barWidth) barWidth = Profile::barWidth;
+    display.drawRect(Profile::barX, Profile::barY, Profile::barWidth, Profile::barHeight, SSD1306_WHITE);
+    display.fillRect(Profile::barX, Profile::barY, barWidth, Profile::barHeight, SSD1306_WHITE);
     
     // Show percentage
-    float percentage = (numerator / denominator) * 100.0;
+    float percentage = numerator * Goals::percentPerLiter[goalIndex];
     display.setTextSize(1);
-    display.setCursor(40, 56);
+    display.setCursor(Profile::percentX, Profile::percentY);
     display.print(percentage, 1); // Display percentage with 1 decimal place
     display.print("% Full");
-    
-    display.display();
+
+    lastFrameUs = micros() - frameStart;
+    if (lastFrameUs > maxFrameUs) maxFrameUs = lastFrameUs;
+
+    // Hand the frame to the flush task instead of a blocking display()
+    frameFlusher.submit(display.getBuffer());
+    scheduler.signal(flushTask);
+}
+
+// **Flush Task** - send one chunk per run so other tasks can interleave
+void flushDisplay() {
+    if (frameFlusher.pump()) {
+        scheduler.signal(flushTask);
+    }
 }
 
 // **Button Press Handling**
+// Button interrupts: timestamp the edge and wake the button task
+void IRAM_ATTR onButtonUpEdge() {
+    buttonUp.edge(digitalRead(Board::buttonUpPin) == LOW, micros());
+    scheduler.signalFromISR(buttonTask);
+}
+
+void IRAM_ATTR onButtonDownEdge() {
+    buttonDown.edge(digitalRead(Board::buttonDownPin) == LOW, micros());
+    scheduler.signalFromISR(buttonTask);
+}
+
+// Log a goal change with the time since the button edge
+void logGoalChange(const Button& button, uint32_t now) {
+    Serial.print("🎯 New Goal: ");
+    Serial.print(denominator);
+    Serial.print(" (");
+    Serial.print(now - button.pressTimeUs());
+    Serial.println(" us after press)");
+}
+
+// **Button Task** - turn debounced presses and repeats into goal changes
 void handleButtonPress() {
-    // Non-blocking button checking
-    static unsigned long lastButtonTime = 0;
-    unsigned long currentTime = millis();
-    
-    if (currentTime - lastButtonTime >= 200) {  // Debounce time
-        if (digitalRead(BUTTON_UP) == LOW) {
-            denominator += 2.5; 
-            if (denominator > 100.0) denominator = 100.0;  // Limit max goal
-            Serial.print("🎯 New Goal: ");
-            Serial.println(denominator);
-            updateDisplay();
-            lastButtonTime = currentTime;
-        }
+    HeapGuard guard("handleButtonPress");
+    uint32_t now = micros();
 
-        if (digitalRead(BUTTON_DOWN) == LOW) {
-            denominator -= 2.5;
-            if (denominator < 5.0) denominator = 5.0;  // Avoid zero
-            Serial.print("🎯 New Goal: ");
-            Serial.println(denominator);
-            updateDisplay();
-            lastButtonTime = currentTime;
-        }
+    // Goals step through the profile's goal table
+    if (buttonUp.update(now)) {
+        if (goalIndex < Profile::goalCount - 1) goalIndex++;  // Limit max goal
+        denominator = Goals::liters[goalIndex];
+        logGoalChange(buttonUp, now);
+        scheduler.signal(gaugeTask);  // Same update path as BLE data
+    }
+
+    if (buttonDown.update(now)) {
+        if (goalIndex > 0) goalIndex--;  // Avoid zero
+        denominator = Goals::liters[goalIndex];
+        logGoalChange(buttonDown, now);
+        scheduler.signal(gaugeTask);
+    }
+
+    // Come back for the next repeat or release check
+    uint32_t waitUs = buttonUp.timeUntilUpdateUs(now);
+    uint32_t waitDownUs = buttonDown.timeUntilUpdateUs(now);
+    if (waitDownUs < waitUs) waitUs = waitDownUs;
+    if (waitUs != Button::NEVER) {
+        scheduler.runAfter(buttonTask, (waitUs + 999) / 1000);
     }
 }
 
@@ -550,21 +872,36 @@ void setup() {
     Serial.println("\n\n🚀 Starting up water tracker device...");
     delay(1000);
 
+    // Register tasks (setup() runs on the loop task)
+    scheduler.begin();
+    buttonTask = scheduler.addEventTask("buttons", handleButtonPress, 10);
+    displayTask = scheduler.addTask("display", refreshDisplay, 1000);
+    gaugeTask = scheduler.addEventTask("gauge", updateGauge);
+    stepperTask = scheduler.addEventTask("stepper", runStepper, Gauge::phaseIntervalMs);
+    bleTask = scheduler.addEventTask("ble", manageBLE);
+    syncTask = scheduler.addTask("sync", runClockSync, syncInterval);
+    consoleTask = scheduler.addEventTask("console", handleSerialCommands);
+    scheduler.signalOnSerialInput(consoleTask);
+    heapTask = scheduler.addTask("heap", logHeapTask, heapLogInterval);
+    flushTask = scheduler.addEventTask("flush", flushDisplay, 5);
+
     // Initialize I2C and OLED
-    Wire.begin(SDA_PIN, SCL_PIN);
-    if(!display.begin(SSD1306_SWITCHCAPVCC, I2C_ADDRESS)) {
+    Wire.begin(Board::sdaPin, Board::sclPin);
+    if(!display.begin(SSD1306_SWITCHCAPVCC, Panel::i2cAddress)) {
         Serial.println("SSD1306 allocation failed");
         for(;;); // Don't proceed, loop forever
     }
     
     // Set up IO pins
-    pinMode(BUTTON_UP, INPUT_PULLUP);
-    pinMode(BUTTON_DOWN, INPUT_PULLUP);
-    pinMode(LED_PIN, OUTPUT);
-    pinMode(MOTOR_PIN_1, OUTPUT);
-    pinMode(MOTOR_PIN_2, OUTPUT);
-    pinMode(MOTOR_PIN_3, OUTPUT);
-    pinMode(MOTOR_PIN_4, OUTPUT);
+    pinMode(Board::buttonUpPin, INPUT_PULLUP);
+    pinMode(Board::buttonDownPin, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(Board::buttonUpPin), onButtonUpEdge, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(Board::buttonDownPin), onButtonDownEdge, CHANGE);
+    pinMode(Board::ledPin, OUTPUT);
+    pinMode(Board::motorPin1, OUTPUT);
+    pinMode(Board::motorPin2, OUTPUT);
+    pinMode(Board::motorPin3, OUTPUT);
+    pinMode(Board::motorPin4, OUTPUT);
 
     // Reset all variables to starting values
     resetVariables();
@@ -579,7 +916,7 @@ void setup() {
     display.println("Initializing motor");
     display.display();
 
-    // First reset stepper to zero position by moving back 170 steps
+    // First reset stepper to zero position by driving into the end stop
     resetStepperToZero();
     
     // Update display with zeroed position
@@ -594,63 +931,169 @@ void setup() {
     
     // Initialize BLE scan
     pBLEScan = BLEDevice::getScan();
-    pBLEScan->setAdvertisedDeviceCallbacks(new MyAdvertisedDeviceCallbacks());
+    pBLEScan->setAdvertisedDeviceCallbacks(&advertisedDeviceCallbacks);
     pBLEScan->setActiveScan(true);
     pBLEScan->setInterval(100);
     pBLEScan->setWindow(99);
+
+    // Create the single BLE client reused across reconnects
+    pClient = BLEDevice::createClient();
+    pClient->setClientCallbacks(&clientCallback);
+    connectTaskHandle = xTaskCreateStatic(connectTaskMain, "connect", connectStackBytes, NULL, 1,
+                                          connectStack, &connectTaskBuffer);
     
     // Begin scanning for BLE devices
     doScan = true;
+    scheduler.signal(bleTask);
     
     Serial.println("✅ Setup complete, ready to track water consumption!");
+    logHeapStats("setup");
+    heapLocked = true;  // No guarded allocations from here on
 }
 
-// **Loop Function - Non-blocking design**
-void loop() {
-    // Handle BLE connection
+// **BLE Task** - connect after a scan match, otherwise keep scanning
+void scanComplete(BLEScanResults) {
+    HeapGuard guard("scanComplete");
+    scanning = false;
+    if (!connected && !doConnect) doScan = true;  // Nothing found, scan again
+    scheduler.signalFromTask(bleTask);
+}
+
+// Waits for a kick from the ble task, connects, then reports back
+void connectTaskMain(void*) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        runConnect();
+    }
+}
+
+// One connect attempt on the connect task
+void runConnect() {
+    connectResult = connectToServer();
+    connectBusy = false;
+    scheduler.signalFromTask(bleTask);
+}
+
+void manageBLE() {
+    if (connectBusy) return;  // The connect task signals us when it finishes
+
+    if (connectStarted) {
+        connectStarted = false;
+        Serial.print(connectResult ? "✅ Connected to BLE Server in " : "❌ BLE Connection Failed after ");
+        Serial.print(millis() - connectStartMs);
+        Serial.println(" ms");
+        if (!connectResult) doScan = true;  // Restart scanning
+    }
+
     if (doConnect) {
         Serial.println("🔗 Attempting to connect to BLE Server...");
-        if (connectToServer()) {
-            Serial.println("✅ Connected to BLE Server!");
-        } else {
-            Serial.println("❌ BLE Connection Failed! Retrying...");
-            doScan = true;  // Restart scanning
-        }
         doConnect = false;
+        connectStarted = true;
+        connectBusy = true;
+        connectStartMs = millis();
+        xTaskNotifyGive(connectTaskHandle);
+        return;
     }
 
     // If disconnected, restart BLE scan
-    if (!connected && doScan) {
+    if (!connected && doScan && !scanning) {
         Serial.println("\n🔎 SCANNING FOR BLE DEVICES...");
         Serial.print("Looking for Service UUID: ");
-        Serial.println(serviceUUID.toString().c_str());
+        Serial.println(Ble::serviceUuid());
         
         // Set active scanning for better results
         pBLEScan->setActiveScan(true);
         pBLEScan->setInterval(100);
         pBLEScan->setWindow(99);
         
-        // Start scan with longer duration (10 seconds)
-        pBLEScan->start(10, false);
-        
-        // No direct error check as start() returns BLEScanResults, not bool
+        // Start a 10 second scan in the background, scanComplete() reports back
+        scanning = true;
+        bool started;
+        {
+            // The scan result buffer and the GAP start command are library allocations
+            HeapExempt exempt;
+            pBLEScan->clearResults();  // Free the previous scan result buffer
+            started = pBLEScan->start(10, scanComplete, false);
+        }
+        if (!started) {
+            Serial.println("❌ Failed to start BLE scan");
+            scanning = false;
+            scheduler.runAfter(bleTask, 1000);
+            return;
+        }
         
         doScan = false;  // Don't start another scan until this one finishes
     }
+}
 
-    // Check for button presses to update the water goal
-    handleButtonPress();
+// **Display Task** - periodic refresh, also signaled on changes
+void refreshDisplay() {
+    updateDisplay();
+}
 
-    // Refresh display periodically (e.g., every 1 second)
-    static unsigned long lastUpdate = 0;
-    unsigned long currentMillis = millis();
-    
-    if (currentMillis - lastUpdate > 1000) {
-        Serial.println("🔄 Updating Display...");
-        updateDisplay();
-        lastUpdate = currentMillis;
+// **Clock Sync Task** - keep the clock offset fresh against crystal drift
+void runClockSync() {
+    if (!connected || pSyncCharacteristic == NULL) return;
+
+    sendSyncRequest();
+    if (!linkStats.clockSynced()) {
+        scheduler.runAfter(syncTask, 1000);  // Retry quickly until synced
+    }
+}
+
+// **Console Task** - 'h' link stats, 'r' reset link stats, 't' task stats,
+// 'f' frame stats. Runs when serial input arrives.
+void handleSerialCommands() {
+    while (Serial.available()) {
+        char command = Serial.read();
+        if (command == 'h') {
+            dumpLinkStats();
+        } else if (command == 'r') {
+            linkStats.resetStats();
+            Serial.println("Link statistics reset");
+        } else if (command == 't') {
+            Serial.println("\n⏱️ TASK STATISTICS ⏱️");
+            scheduler.printStats(Serial);
+        } else if (command == 'f') {
+            dumpFrameStats();
+        }
     }
+}
 
-    // Small delay to prevent CPU hogging
-    delay(50);
-}
\ No newline at end of file
+// Print render time separately from I2C flush time
+void dumpFrameStats() {
+    const FrameFlusher<Profile::frameBytes>::Stats& stats = frameFlusher.stats();
+    Serial.println("\n🖥️ FRAME STATISTICS 🖥️");
+    Serial.print("Render: last ");
+    Serial.print(lastFrameUs);
+    Serial.print(" us, max ");
+    Serial.print(maxFrameUs);
+    Serial.println(" us");
+    Serial.print("Flush: last ");
+    Serial.print(stats.lastFlushUs);
+    Serial.print(" us (");
+    Serial.print(stats.lastBusUs);
+    Serial.print(" us on the bus), max ");
+    Serial.print(stats.maxFlushUs);
+    Serial.print(" us, longest chunk ");
+    Serial.print(stats.maxChunkUs);
+    Serial.println(" us");
+    Serial.print("Frames: submitted ");
+    Serial.print(stats.framesSubmitted);
+    Serial.print(", flushed ");
+    Serial.print(stats.framesFlushed);
+    Serial.print(", coalesced ");
+    Serial.println(stats.framesCoalesced);
+}
+
+// **Heap Task** - log heap usage to spot leaks and fragmentation
+void logHeapTask() {
+    logHeapStats("loop");
+}
+
+// **Loop Function** - run ready tasks, then sleep until the next deadline
+// or until a callback or interrupt signals a task
+void loop() {
+    HeapGuard guard("loop");
+    scheduler.runOnce();
+}
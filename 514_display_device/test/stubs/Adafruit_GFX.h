@@ -0,0 +1,21 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Drawing is a no-op, only the calls main.cpp makes are here
+class Adafruit_GFX : public Print {
+public:
+    Adafruit_GFX(int16_t w, int16_t h) : width_(w), height_(h) {}
+    virtual ~Adafruit_GFX() {}
+    void setTextSize(uint8_t) {}
+    void setTextColor(uint16_t) {}
+    void setCursor(int16_t, int16_t) {}
+    void drawRect(int16_t, int16_t, int16_t, int16_t, uint16_t) {}
+    void fillRect(int16_t, int16_t, int16_t, int16_t, uint16_t) {}
+    int16_t width() const { return width_; }
+    int16_t height() const { return height_; }
+
+protected:
+    int16_t width_;
+    int16_t height_;
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <Adafruit_GFX.h>
+#include <Wire.h>
+
+#define SSD1306_WHITE 1
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_COLUMNADDR 0x21
+#define SSD1306_PAGEADDR 0x22
+
+// Like the library, the frame buffer is allocated once in begin()
+class Adafruit_SSD1306 : public Adafruit_GFX {
+public:
+    Adafruit_SSD1306(int16_t w, int16_t h, TwoWire*, int8_t, uint32_t = 400000, uint32_t = 100000)
+        : Adafruit_GFX(w, h), buffer_(NULL) {}
+    ~Adafruit_SSD1306() { free(buffer_); }
+
+    bool begin(uint8_t, uint8_t) {
+        if (buffer_ == NULL) buffer_ = (uint8_t*)malloc(width_ * height_ / 8);
+        if (buffer_ != NULL) clearDisplay();
+        return buffer_ != NULL;
+    }
+    void clearDisplay() { memset(buffer_, 0, width_ * height_ / 8); }
+    void display() {}
+    uint8_t* getBuffer() { return buffer_; }
+
+private:
+    uint8_t* buffer_;
+};
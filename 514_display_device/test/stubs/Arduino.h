@@ -0,0 +1,107 @@
+#pragma once
+
+// **Host Arduino/FreeRTOS Stand-In**
+// Just enough of the Arduino-ESP32 core for test_soak to build src/main.cpp
+// on a host. Time is a fake clock the test advances; pins, Serial and the
+// heap queries do nothing. The globals are defined in the test.
+
+#include <ctype.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT_PULLUP 0x05
+#define OUTPUT 0x03
+#define CHANGE 0x03
+#define HEX 16
+#define IRAM_ATTR
+
+// **Time** - advanced by the test (and by delay())
+extern uint32_t fakeMicros;
+inline unsigned long micros() { return fakeMicros; }
+inline unsigned long millis() { return fakeMicros / 1000; }
+inline void delay(unsigned long ms) { fakeMicros += ms * 1000; }
+
+// **GPIO**
+inline void pinMode(int, int) {}
+inline void digitalWrite(int, int) {}
+inline int digitalRead(int) { return HIGH; }
+inline int digitalPinToInterrupt(int pin) { return pin; }
+inline void attachInterrupt(int, void (*)(), int) {}
+
+inline char* dtostrf(double value, signed char width, unsigned char precision, char* out) {
+    sprintf(out, "%*.*f", width, precision, value);
+    return out;
+}
+
+// **Serial** - output is discarded, nothing is ever received
+class Print {
+public:
+    template <class T> size_t print(T) { return 0; }
+    template <class T> size_t print(T, int) { return 0; }
+    template <class T> size_t println(T) { return 0; }
+    template <class T> size_t println(T, int) { return 0; }
+    size_t println() { return 0; }
+};
+
+class HardwareSerial : public Print {
+public:
+    HardwareSerial() : onReceive_(NULL), input_(NULL) {}
+    void begin(unsigned long) {}
+    void onReceive(void (*callback)()) { onReceive_ = callback; }
+    int available() { return input_ != NULL && *input_ ? 1 : 0; }
+    int read() { return available() ? *input_++ : -1; }
+
+    // Test hook: characters typed on the console
+    void receive(const char* input) {
+        input_ = input;
+        if (onReceive_ != NULL) onReceive_();
+    }
+
+private:
+    void (*onReceive_)();
+    const char* input_;
+};
+extern HardwareSerial Serial;
+
+class EspClass {
+public:
+    uint32_t getFreeHeap() { return 0; }
+    uint32_t getMinFreeHeap() { return 0; }
+    uint32_t getMaxAllocHeap() { return 0; }
+};
+extern EspClass ESP;
+
+// **FreeRTOS** - a single thread, so notifications only need to be counted
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+typedef uint8_t StackType_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+struct StaticTask_t { int unused; };
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define portMAX_DELAY 0xFFFFFFFF
+#define pdMS_TO_TICKS(ms) (ms)
+#define portYIELD_FROM_ISR(woken) (void)(woken)
+
+extern uint32_t taskNotifications;
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return &taskNotifications; }
+inline void xTaskNotifyGive(TaskHandle_t) { taskNotifications++; }
+inline void vTaskNotifyGiveFromISR(TaskHandle_t, BaseType_t*) { taskNotifications++; }
+inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+
+// The task is not started, the test runs its body itself
+inline TaskHandle_t xTaskCreateStatic(TaskFunction_t, const char*, uint32_t, void*, unsigned,
+                                      StackType_t*, StaticTask_t* buffer) {
+    return buffer;
+}
@@ -0,0 +1,252 @@
+#pragma once
+
+// **Host BLE Client Stand-In**
+// Models the parts of the ESP32 BLE library that main.cpp uses, including
+// where the library allocates: createClient() news a client, the service
+// and characteristic maps are built on discovery and freed on disconnect.
+// One fake sensor is always in range; the test drives its notifications.
+
+#include <Arduino.h>
+
+class BLEUUID {
+public:
+    BLEUUID(const char* uuid = "") {
+        strncpy(uuid_, uuid, sizeof(uuid_) - 1);
+        uuid_[sizeof(uuid_) - 1] = '\0';
+    }
+    bool equals(const BLEUUID& other) const { return strcmp(uuid_, other.uuid_) == 0; }
+    std::string toString() const { return uuid_; }
+
+private:
+    char uuid_[37];
+};
+
+typedef uint8_t esp_bd_addr_t[6];
+#define ESP_BD_ADDR_LEN 6
+
+typedef enum {
+    BLE_ADDR_TYPE_PUBLIC = 0,
+    BLE_ADDR_TYPE_RANDOM = 1,
+} esp_ble_addr_type_t;
+
+class BLEAddress {
+public:
+    BLEAddress(const esp_bd_addr_t address) { memcpy(address_, address, ESP_BD_ADDR_LEN); }
+
+    esp_bd_addr_t* getNative() { return &address_; }
+    bool equals(const BLEAddress& other) const { return memcmp(address_, other.address_, ESP_BD_ADDR_LEN) == 0; }
+    std::string toString() const {
+        char text[18];
+        snprintf(text, sizeof(text), "%02x:%02x:%02x:%02x:%02x:%02x", address_[0], address_[1], address_[2],
+                 address_[3], address_[4], address_[5]);
+        return text;
+    }
+
+private:
+    esp_bd_addr_t address_;
+};
+
+class BLEAdvertisedDevice {
+public:
+    BLEAdvertisedDevice() : name_(""), haveUuid_(false) {}
+    BLEAdvertisedDevice(const char* name, const BLEUUID& uuid) : name_(name), uuid_(uuid), haveUuid_(true) {}
+
+    std::string getName() const { return name_; }
+    BLEAddress getAddress() const {
+        static const esp_bd_addr_t address = {0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff};
+        return BLEAddress(address);
+    }
+    esp_ble_addr_type_t getAddressType() const { return BLE_ADDR_TYPE_RANDOM; }
+    int getRSSI() const { return -60; }
+    bool haveServiceUUID() const { return haveUuid_; }
+    int getServiceUUIDCount() const { return haveUuid_ ? 1 : 0; }
+    BLEUUID getServiceUUID(int) const { return uuid_; }
+    bool isAdvertisingService(const BLEUUID& uuid) const { return haveUuid_ && uuid_.equals(uuid); }
+
+private:
+    const char* name_;
+    BLEUUID uuid_;
+    bool haveUuid_;
+};
+
+class BLEAdvertisedDeviceCallbacks {
+public:
+    virtual ~BLEAdvertisedDeviceCallbacks() {}
+    virtual void onResult(BLEAdvertisedDevice advertisedDevice) = 0;
+};
+
+class BLEScanResults {};
+
+class BLEScan {
+public:
+    BLEScan() : callbacks_(NULL), running_(false), starts(0) {}
+    void setAdvertisedDeviceCallbacks(BLEAdvertisedDeviceCallbacks* callbacks) { callbacks_ = callbacks; }
+    void setActiveScan(bool) {}
+    void setInterval(uint16_t) {}
+    void setWindow(uint16_t) {}
+    bool start(uint32_t, void (*)(BLEScanResults), bool) {
+        running_ = true;
+        starts++;
+        return true;
+    }
+    void stop() { running_ = false; }
+    void clearResults() {}
+    bool isScanning() const { return running_; }
+
+    // Test hook: the sensor's advertisement arrives
+    void advertise(const BLEAdvertisedDevice& device) {
+        if (running_ && callbacks_ != NULL) callbacks_->onResult(device);
+    }
+
+private:
+    BLEAdvertisedDeviceCallbacks* callbacks_;
+    bool running_;
+
+public:
+    uint32_t starts;  // Scans started
+};
+
+class BLERemoteCharacteristic;
+typedef void (*notify_callback)(BLERemoteCharacteristic*, uint8_t*, size_t, bool);
+
+class BLERemoteCharacteristic {
+public:
+    explicit BLERemoteCharacteristic(const BLEUUID& uuid) : uuid_(uuid), callback_(NULL), written_(0) {}
+
+    BLEUUID getUUID() const { return uuid_; }
+    bool canRead() const { return true; }
+    bool canWrite() const { return true; }
+    bool canNotify() const { return true; }
+    bool canIndicate() const { return false; }
+    std::string readValue() const { return "0.0"; }
+    void registerForNotify(notify_callback callback) { callback_ = callback; }
+    void writeValue(uint8_t* data, size_t length, bool = false) {
+        written_ = length < sizeof(lastWrite_) ? length : sizeof(lastWrite_);
+        memcpy(lastWrite_, data, written_);
+    }
+
+    // Test hooks: the peer notifies, and what was last written to it
+    void notify(const void* data, size_t length) {
+        if (callback_ != NULL) callback_(this, (uint8_t*)data, length, true);
+    }
+    const uint8_t* lastWrite() const { return lastWrite_; }
+    size_t lastWriteLength() const { return written_; }
+
+private:
+    BLEUUID uuid_;
+    notify_callback callback_;
+    uint8_t lastWrite_[32];
+    size_t written_;
+};
+
+class BLERemoteService {
+public:
+    BLERemoteService(const BLEUUID& uuid, const char* const* characteristics, int count) : uuid_(uuid) {
+        for (int i = 0; i < count; i++) {
+            characteristics_[characteristics[i]] = new BLERemoteCharacteristic(BLEUUID(characteristics[i]));
+        }
+    }
+    ~BLERemoteService() {
+        for (std::map<std::string, BLERemoteCharacteristic*>::iterator it = characteristics_.begin();
+             it != characteristics_.end(); ++it) {
+            delete it->second;
+        }
+    }
+
+    BLEUUID getUUID() const { return uuid_; }
+    std::map<std::string, BLERemoteCharacteristic*>* getCharacteristics() { return &characteristics_; }
+    BLERemoteCharacteristic* getCharacteristic(const BLEUUID& uuid) {
+        std::map<std::string, BLERemoteCharacteristic*>::iterator it = characteristics_.find(uuid.toString());
+        return it == characteristics_.end() ? NULL : it->second;
+    }
+
+private:
+    BLEUUID uuid_;
+    std::map<std::string, BLERemoteCharacteristic*> characteristics_;
+};
+
+class BLEClient;
+
+class BLEClientCallbacks {
+public:
+    virtual ~BLEClientCallbacks() {}
+    virtual void onConnect(BLEClient* client) = 0;
+    virtual void onDisconnect(BLEClient* client) = 0;
+};
+
+// The peer the client connects to; set by the test
+struct BLEPeer {
+    const char* serviceUuid;
+    const char* const* characteristicUuids;
+    int characteristicCount;
+    bool refuseConnect;
+};
+extern BLEPeer blePeer;
+
+class BLEClient {
+public:
+    BLEClient() : callbacks_(NULL), connected_(false) { instances++; }
+    ~BLEClient() {
+        clearServices();
+        instances--;
+    }
+
+    void setClientCallbacks(BLEClientCallbacks* callbacks) { callbacks_ = callbacks; }
+
+    bool connect(BLEAddress address, esp_ble_addr_type_t type = BLE_ADDR_TYPE_PUBLIC) {
+        if (connected_ || blePeer.refuseConnect) return false;
+        // Only the fake sensor is in range, at the address it advertises
+        if (!address.equals(BLEAdvertisedDevice().getAddress()) || type != BLE_ADDR_TYPE_RANDOM) return false;
+        connected_ = true;
+        if (callbacks_ != NULL) callbacks_->onConnect(this);
+        return true;
+    }
+
+    // Link lost or closed: the library drops its GATT cache, then reports
+    void disconnect() {
+        if (!connected_) return;
+        connected_ = false;
+        clearServices();
+        if (callbacks_ != NULL) callbacks_->onDisconnect(this);
+    }
+
+    bool isConnected() const { return connected_; }
+
+    std::map<std::string, BLERemoteService*>* getServices() {
+        if (connected_ && services_.empty()) {
+            services_[blePeer.serviceUuid] = new BLERemoteService(
+                BLEUUID(blePeer.serviceUuid), blePeer.characteristicUuids, blePeer.characteristicCount);
+        }
+        return &services_;
+    }
+
+    BLERemoteService* getService(const BLEUUID& uuid) {
+        std::map<std::string, BLERemoteService*>* services = getServices();
+        std::map<std::string, BLERemoteService*>::iterator it = services->find(uuid.toString());
+        return it == services->end() ? NULL : it->second;
+    }
+
+    static int instances;  // Live clients
+
+private:
+    void clearServices() {
+        for (std::map<std::string, BLERemoteService*>::iterator it = services_.begin(); it != services_.end(); ++it) {
+            delete it->second;
+        }
+        services_.clear();
+    }
+
+    BLEClientCallbacks* callbacks_;
+    bool connected_;
+    std::map<std::string, BLERemoteService*> services_;
+};
+
+class BLEDevice {
+public:
+    static void init(const char*) {}
+    static BLEScan* getScan() {
+        static BLEScan scan;
+        return &scan;
+    }
+    static BLEClient* createClient() { return new BLEClient(); }
+};
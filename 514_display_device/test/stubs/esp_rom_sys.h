@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stdio.h>
+
+inline int esp_rom_printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int n = vprintf(format, args);
+    va_end(args);
+    return n;
+}
@@ -0,0 +1,160 @@
+#include <unity.h>
+#include <Button.h>
+
+// Same timing as the firmware
+static const Button::Config config = {
+    20000,   // Release must be stable for 20 ms
+    400000,  // Hold 400 ms before repeating
+    200000,  // Interval between the first repeats
+    40000,   // Repeat no faster than every 40 ms
+    80       // Each repeat comes 20% sooner
+};
+
+void setUp() {}
+void tearDown() {}
+
+// Run update() whenever the button asks for it, up to endUs, and record
+// the times a press or repeat was reported
+static int runUntil(Button& button, uint32_t startUs, uint32_t endUs, uint32_t* times, int maxTimes) {
+    uint32_t now = startUs;
+    int count = 0;
+    for (;;) {
+        uint32_t wait = button.timeUntilUpdateUs(now);
+        if (wait == Button::NEVER || wait > endUs - now) break;
+        now += wait;
+        if (button.update(now) && count < maxTimes) times[count++] = now;
+    }
+    return count;
+}
+
+void test_press_accepted_on_first_edge() {
+    Button button(config);
+    button.edge(true, 1000);
+
+    TEST_ASSERT_EQUAL_UINT32(0, button.timeUntilUpdateUs(1050));
+    TEST_ASSERT_EQUAL(1, button.update(1050));
+    TEST_ASSERT_TRUE(button.isPressed());
+    TEST_ASSERT_EQUAL_UINT32(1000, button.pressTimeUs());
+}
+
+void test_press_bounces_give_one_press() {
+    Button button(config);
+    int presses = 0;
+    bool level = true;
+    for (uint32_t t = 1000; t <= 3000; t += 250) {
+        button.edge(level, t);
+        presses += button.update(t + 10);
+        level = !level;
+    }
+    button.edge(true, 3250);  // Settles pressed
+    presses += button.update(3300);
+
+    TEST_ASSERT_EQUAL(1, presses);
+    TEST_ASSERT_TRUE(button.isPressed());
+}
+
+void test_release_bounces_absorbed() {
+    Button button(config);
+    button.edge(true, 0);
+    TEST_ASSERT_EQUAL(1, button.update(0));
+
+    // Release with bounces inside the 20 ms window
+    button.edge(false, 100000);
+    button.edge(true, 100300);
+    button.edge(false, 100600);
+    TEST_ASSERT_EQUAL(0, button.update(100700));
+    TEST_ASSERT_TRUE(button.isPressed());
+    TEST_ASSERT_EQUAL_UINT32(19900, button.timeUntilUpdateUs(100700));
+
+    TEST_ASSERT_EQUAL(0, button.update(120599));
+    TEST_ASSERT_TRUE(button.isPressed());
+    TEST_ASSERT_EQUAL(0, button.update(120600));
+    TEST_ASSERT_FALSE(button.isPressed());
+
+    // The bounce must not come back as a second press
+    TEST_ASSERT_EQUAL_UINT32(Button::NEVER, button.timeUntilUpdateUs(130000));
+    TEST_ASSERT_EQUAL(0, button.update(130000));
+}
+
+void test_glitch_while_held_does_not_release() {
+    Button button(config);
+    button.edge(true, 0);
+    TEST_ASSERT_EQUAL(1, button.update(0));
+
+    button.edge(false, 100000);
+    button.edge(true, 105000);  // Back down after 5 ms
+    TEST_ASSERT_EQUAL(0, button.update(130000));
+    TEST_ASSERT_TRUE(button.isPressed());
+}
+
+void test_short_tap_is_latched() {
+    Button button(config);
+    // Press and release both happen before the task runs
+    button.edge(true, 1000);
+    button.edge(false, 4000);
+
+    TEST_ASSERT_EQUAL_UINT32(0, button.timeUntilUpdateUs(5000));
+    TEST_ASSERT_EQUAL(1, button.update(5000));
+    TEST_ASSERT_EQUAL_UINT32(1000, button.pressTimeUs());
+
+    TEST_ASSERT_EQUAL(0, button.update(23999));
+    TEST_ASSERT_TRUE(button.isPressed());
+    TEST_ASSERT_EQUAL(0, button.update(24000));
+    TEST_ASSERT_FALSE(button.isPressed());
+    TEST_ASSERT_EQUAL(0, button.update(50000));
+}
+
+void test_repeat_schedule() {
+    Button button(config);
+    button.edge(true, 0);
+    TEST_ASSERT_EQUAL(1, button.update(0));
+
+    // 400 ms delay, then 200 ms, then 80% of the last interval, 40 ms floor
+    const uint32_t expected[] = {
+        400000, 600000, 760000, 888000, 990400, 1072320,
+        1137856, 1190284, 1232226, 1272226, 1312226
+    };
+    const int expectedCount = sizeof(expected) / sizeof(expected[0]);
+    uint32_t times[64];
+    int count = runUntil(button, 0, 2000000, times, 64);
+
+    TEST_ASSERT_GREATER_OR_EQUAL(expectedCount, count);
+    for (int i = 0; i < expectedCount; i++) {
+        TEST_ASSERT_EQUAL_UINT32(expected[i], times[i]);
+    }
+    for (int i = expectedCount; i < count; i++) {
+        TEST_ASSERT_EQUAL_UINT32(40000, times[i] - times[i - 1]);
+    }
+}
+
+void test_micros_wrap() {
+    const uint32_t start = 0xFFFFFFFFu - 100000;
+    Button button(config);
+    button.edge(true, start);
+    TEST_ASSERT_EQUAL(1, button.update(start));
+
+    // First repeat lands after the counter wraps
+    TEST_ASSERT_EQUAL_UINT32(400000, button.timeUntilUpdateUs(start));
+    TEST_ASSERT_EQUAL(0, button.update(start + 399999));
+    TEST_ASSERT_EQUAL(1, button.update(start + 400000));
+
+    // Release debounce across the wrap
+    const uint32_t release = 0xFFFFFFF0u;
+    button.edge(false, release);
+    TEST_ASSERT_EQUAL(0, button.update(release + 19999));
+    TEST_ASSERT_TRUE(button.isPressed());
+    TEST_ASSERT_EQUAL(0, button.update(release + 20000));
+    TEST_ASSERT_FALSE(button.isPressed());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_press_accepted_on_first_edge);
+    RUN_TEST(test_press_bounces_give_one_press);
+    RUN_TEST(test_release_bounces_absorbed);
+    RUN_TEST(test_glitch_while_held_does_not_release);
+    RUN_TEST(test_short_tap_is_latched);
+    RUN_TEST(test_repeat_schedule);
+    RUN_TEST(test_micros_wrap);
+    return UNITY_END();
+}
@@ -0,0 +1,165 @@
+#include <unity.h>
+#include <FrameFlusher.h>
+
+// Same geometry as the firmware: a 1 KB frame in 64 byte chunks
+static const size_t FRAME_BYTES = 1024;
+static const size_t CHUNK_BYTES = 64;
+static const int MAX_FRAMES = 4;
+
+// Fake clock, every read advances it by 10 us
+static uint32_t fakeMicros = 0;
+static uint32_t fakeClock() { return fakeMicros += 10; }
+
+// **Capture Back End** - records the frames and chunk sizes it was sent
+class CaptureBackend : public DisplayBackend {
+public:
+    CaptureBackend() : frames(0), chunks(0), maxChunk(0), offset_(0) {}
+
+    void beginFrame() {
+        frames++;
+        offset_ = 0;
+    }
+
+    void writeData(const uint8_t* data, size_t length) {
+        chunks++;
+        if (length > maxChunk) maxChunk = length;
+        if (frames == 0 || frames > MAX_FRAMES || offset_ + length > FRAME_BYTES) return;
+        memcpy(captured[frames - 1] + offset_, data, length);
+        offset_ += length;
+    }
+
+    int frames;
+    int chunks;
+    size_t maxChunk;
+    uint8_t captured[MAX_FRAMES][FRAME_BYTES];
+
+private:
+    size_t offset_;
+};
+
+// Discards everything; the flusher starts on this one
+class NullBackend : public DisplayBackend {
+public:
+    void beginFrame() {}
+    void writeData(const uint8_t*, size_t) {}
+};
+
+static NullBackend nullBackend;
+static CaptureBackend* capture;
+static FrameFlusher<FRAME_BYTES>* flusher;
+static uint8_t frameA[FRAME_BYTES];
+static uint8_t frameB[FRAME_BYTES];
+static uint8_t frameC[FRAME_BYTES];
+
+void setUp() {
+    memset(frameA, 0xAA, sizeof(frameA));
+    memset(frameB, 0xBB, sizeof(frameB));
+    memset(frameC, 0xCC, sizeof(frameC));
+    capture = new CaptureBackend();
+    flusher = new FrameFlusher<FRAME_BYTES>(nullBackend, CHUNK_BYTES, fakeClock);
+    flusher->setBackend(*capture);
+}
+
+void tearDown() {
+    delete flusher;
+    delete capture;
+}
+
+// Pump until idle, returns the number of pump() calls that did work
+static int pumpAll() {
+    int pumps = 0;
+    while (flusher->isFlushing()) {
+        flusher->pump();
+        pumps++;
+    }
+    return pumps;
+}
+
+void test_frame_sent_in_chunks() {
+    flusher->submit(frameA);
+    TEST_ASSERT_TRUE(flusher->isFlushing());
+    TEST_ASSERT_EQUAL(0, capture->chunks);  // submit() never touches the bus
+
+    TEST_ASSERT_EQUAL(16, pumpAll());
+    TEST_ASSERT_EQUAL(1, capture->frames);
+    TEST_ASSERT_EQUAL(16, capture->chunks);
+    TEST_ASSERT_EQUAL(CHUNK_BYTES, capture->maxChunk);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(frameA, capture->captured[0], FRAME_BYTES);
+    TEST_ASSERT_FALSE(flusher->pump());
+    TEST_ASSERT_EQUAL_UINT32(1, flusher->stats().framesFlushed);
+}
+
+void test_back_buffer_free_after_submit() {
+    flusher->submit(frameA);
+    flusher->pump();
+    memset(frameA, 0x11, sizeof(frameA));  // Drawing the next frame
+    pumpAll();
+
+    uint8_t expected[FRAME_BYTES];
+    memset(expected, 0xAA, sizeof(expected));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, capture->captured[0], FRAME_BYTES);
+}
+
+void test_submit_mid_flush_sent_after_current() {
+    flusher->submit(frameA);
+    for (int i = 0; i < 5; i++) flusher->pump();
+    flusher->submit(frameB);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(frameA, flusher->frontBuffer(), FRAME_BYTES);  // Not replaced mid-flush
+
+    TEST_ASSERT_EQUAL(27, pumpAll());  // 11 chunks left of A, then all of B
+    TEST_ASSERT_EQUAL(2, capture->frames);
+    TEST_ASSERT_EQUAL(32, capture->chunks);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(frameA, capture->captured[0], FRAME_BYTES);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(frameB, capture->captured[1], FRAME_BYTES);
+    TEST_ASSERT_EQUAL_UINT32(0, flusher->stats().framesCoalesced);
+}
+
+void test_last_frame_wins_when_coalesced() {
+    flusher->submit(frameA);
+    flusher->pump();
+    flusher->submit(frameB);
+    flusher->submit(frameC);  // Replaces B before it was sent
+    pumpAll();
+
+    TEST_ASSERT_EQUAL(2, capture->frames);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(frameA, capture->captured[0], FRAME_BYTES);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(frameC, capture->captured[1], FRAME_BYTES);
+    TEST_ASSERT_EQUAL_UINT32(3, flusher->stats().framesSubmitted);
+    TEST_ASSERT_EQUAL_UINT32(2, flusher->stats().framesFlushed);
+    TEST_ASSERT_EQUAL_UINT32(1, flusher->stats().framesCoalesced);
+}
+
+void test_submit_when_idle_not_coalesced() {
+    flusher->submit(frameA);
+    pumpAll();
+    flusher->submit(frameB);
+    pumpAll();
+
+    TEST_ASSERT_EQUAL_UINT32(2, flusher->stats().framesFlushed);
+    TEST_ASSERT_EQUAL_UINT32(0, flusher->stats().framesCoalesced);
+}
+
+void test_flush_timing_stats() {
+    flusher->submit(frameA);
+    pumpAll();
+
+    // Two clock reads per chunk, 10 us apart
+    TEST_ASSERT_EQUAL_UINT32(10, flusher->stats().maxChunkUs);
+    TEST_ASSERT_EQUAL_UINT32(16 * 10, flusher->stats().lastBusUs);
+    TEST_ASSERT_EQUAL_UINT32(16 * 20 - 10, flusher->stats().lastFlushUs);
+
+    flusher->resetStats();
+    TEST_ASSERT_EQUAL_UINT32(0, flusher->stats().framesFlushed);
+    TEST_ASSERT_EQUAL_UINT32(0, flusher->stats().maxFlushUs);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_frame_sent_in_chunks);
+    RUN_TEST(test_back_buffer_free_after_submit);
+    RUN_TEST(test_submit_mid_flush_sent_after_current);
+    RUN_TEST(test_last_frame_wins_when_coalesced);
+    RUN_TEST(test_submit_when_idle_not_coalesced);
+    RUN_TEST(test_flush_timing_stats);
+    return UNITY_END();
+}
@@ -0,0 +1,199 @@
+#include <unity.h>
+#include <LinkStats.h>
+
+static LinkStats* link;
+
+void setUp() {
+    link = new LinkStats();
+}
+
+void tearDown() {
+    delete link;
+}
+
+// A sync exchange: the sensor clock reads offsetUs ahead of ours, the
+// request takes upUs, the sensor holds it turnUs, the reply takes downUs
+static SyncPacket exchange(uint32_t t1, uint32_t offsetUs, uint32_t upUs, uint32_t turnUs,
+                           uint32_t downUs, uint32_t* t4) {
+    SyncPacket reply;
+    reply.t1 = t1;
+    reply.t2 = t1 + upUs + offsetUs;
+    reply.t3 = reply.t2 + turnUs;
+    *t4 = t1 + upUs + turnUs + downUs;
+    return reply;
+}
+
+static void syncTo(uint32_t t1, uint32_t offsetUs) {
+    uint32_t t4;
+    SyncPacket reply = exchange(t1, offsetUs, 1000, 200, 1000, &t4);
+    TEST_ASSERT_TRUE(link->onSyncReply(reply, t4));
+}
+
+static DataPacket packet(uint32_t seq, uint32_t sensorUs) {
+    DataPacket p = { seq, sensorUs, 1.0f };
+    return p;
+}
+
+void test_packets_are_wire_sized() {
+    TEST_ASSERT_EQUAL(12, sizeof(DataPacket));
+    TEST_ASSERT_EQUAL(12, sizeof(SyncPacket));
+}
+
+void test_offset_symmetric_legs() {
+    uint32_t t4;
+    SyncPacket reply = exchange(100000, 5000, 1000, 200, 1000, &t4);
+    TEST_ASSERT_FALSE(link->clockSynced());
+    TEST_ASSERT_TRUE(link->onSyncReply(reply, t4));
+    TEST_ASSERT_TRUE(link->clockSynced());
+    TEST_ASSERT_EQUAL_INT(5000, link->clockOffsetUs());
+    TEST_ASSERT_EQUAL_UINT32(2000, link->bestRttUs());  // Sensor hold time excluded
+}
+
+// Unequal legs put half the difference into the offset
+void test_offset_asymmetric_legs() {
+    uint32_t t4;
+    SyncPacket reply = exchange(100000, 5000, 3000, 200, 1000, &t4);
+    link->onSyncReply(reply, t4);
+    TEST_ASSERT_EQUAL_INT(6000, link->clockOffsetUs());
+    TEST_ASSERT_EQUAL_UINT32(4000, link->bestRttUs());
+}
+
+void test_offset_negative() {
+    uint32_t t4;
+    SyncPacket reply = exchange(100000, (uint32_t)-70000, 1000, 200, 1000, &t4);
+    link->onSyncReply(reply, t4);
+    TEST_ASSERT_EQUAL_INT(-70000, link->clockOffsetUs());
+}
+
+// Our clock wraps between sending the request and getting the reply
+void test_offset_our_clock_wraps() {
+    uint32_t t4;
+    SyncPacket reply = exchange(0xFFFFFC00, 5000, 1000, 200, 1000, &t4);
+    TEST_ASSERT_TRUE(t4 < reply.t1);
+    link->onSyncReply(reply, t4);
+    TEST_ASSERT_EQUAL_INT(5000, link->clockOffsetUs());
+    TEST_ASSERT_EQUAL_UINT32(2000, link->bestRttUs());
+}
+
+// Clocks almost 2^31 us apart, where summing the two signed legs overflowed
+void test_offset_clocks_far_apart() {
+    uint32_t t4;
+    SyncPacket reply = exchange(1000000, 0x7FFFF000, 1000, 200, 1000, &t4);
+    link->onSyncReply(reply, t4);
+    TEST_ASSERT_EQUAL_INT(0x7FFFF000, link->clockOffsetUs());
+
+    // The sensor clock wraps before the next packet
+    uint32_t sent = t4 + 0x80000000u + 0x7FFFF000;
+    TEST_ASSERT_TRUE(sent < reply.t3);
+    link->onPacket(packet(0, sent), t4 + 0x80000000u + 8000);
+    TEST_ASSERT_EQUAL_UINT32(8000, link->stats().maxLatencyUs);
+}
+
+// Only replies with a round trip within twice the best are trusted
+void test_rtt_filter() {
+    uint32_t t4;
+    SyncPacket reply = exchange(100000, 5000, 1000, 200, 1000, &t4);
+    TEST_ASSERT_TRUE(link->onSyncReply(reply, t4));
+
+    reply = exchange(200000, 9000, 4000, 200, 1000, &t4);  // RTT 5000
+    TEST_ASSERT_FALSE(link->onSyncReply(reply, t4));
+    TEST_ASSERT_EQUAL_INT(5000, link->clockOffsetUs());
+
+    reply = exchange(300000, 6000, 2000, 200, 2000, &t4);  // RTT 4000
+    TEST_ASSERT_TRUE(link->onSyncReply(reply, t4));
+    TEST_ASSERT_EQUAL_INT(6000, link->clockOffsetUs());
+
+    reply = exchange(400000, 7000, 500, 200, 500, &t4);  // New best
+    TEST_ASSERT_TRUE(link->onSyncReply(reply, t4));
+    TEST_ASSERT_EQUAL_UINT32(1000, link->bestRttUs());
+}
+
+void test_start_connection_forgets_sync_and_sequence() {
+    syncTo(100000, 5000);
+    link->onPacket(packet(41, 0), 0);
+    link->startConnection();
+
+    TEST_ASSERT_FALSE(link->clockSynced());
+    TEST_ASSERT_EQUAL_UINT32(0, link->bestRttUs());
+    link->onPacket(packet(0, 0), 0);  // Restarted sensor, not a reset or gap
+    TEST_ASSERT_EQUAL_UINT32(0, link->stats().sequenceResets);
+    TEST_ASSERT_EQUAL_UINT32(0, link->stats().gapEvents);
+    TEST_ASSERT_EQUAL_UINT32(2, link->stats().packetsReceived);
+}
+
+void test_sequence_gaps_and_resets() {
+    const uint32_t seqs[] = {0, 1, 2, 5, 6, 9, 10, 3, 3};
+    for (unsigned i = 0; i < sizeof(seqs) / sizeof(seqs[0]); i++) {
+        link->onPacket(packet(seqs[i], 0), 0);
+    }
+    TEST_ASSERT_EQUAL_UINT32(9, link->stats().packetsReceived);
+    TEST_ASSERT_EQUAL_UINT32(4, link->stats().packetsLost);  // 3, 4, 7, 8
+    TEST_ASSERT_EQUAL_UINT32(2, link->stats().gapEvents);
+    TEST_ASSERT_EQUAL_UINT32(2, link->stats().sequenceResets);  // 10 -> 3, 3 -> 3
+}
+
+void test_no_latency_until_synced() {
+    link->onPacket(packet(0, 0), 500000);
+    TEST_ASSERT_EQUAL_UINT32(0, link->stats().maxLatencyUs);
+    for (int i = 0; i < LinkStats::LATENCY_BUCKETS; i++) {
+        TEST_ASSERT_EQUAL_UINT32(0, link->stats().latencyHistogram[i]);
+    }
+}
+
+void test_latency_buckets() {
+    syncTo(100000, 5000);
+    const uint32_t latenciesUs[] = {0, 4999, 5000, 19999, 150000, 1999999, 2000000, 30000000};
+    const int buckets[] = {0, 0, 1, 2, 5, 8, 9, 9};
+    uint32_t receive = 200000;
+    for (int i = 0; i < 8; i++) {
+        receive += 1000;
+        uint32_t sent = receive - latenciesUs[i] + 5000;  // Sensor clock
+        link->onPacket(packet(i, sent), receive);
+    }
+
+    uint32_t expected[LinkStats::LATENCY_BUCKETS] = {};
+    for (int i = 0; i < 8; i++) expected[buckets[i]]++;
+    for (int i = 0; i < LinkStats::LATENCY_BUCKETS; i++) {
+        TEST_ASSERT_EQUAL_UINT32(expected[i], link->stats().latencyHistogram[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(30000000, link->stats().maxLatencyUs);
+}
+
+// A packet that seems to arrive before it was sent is within sync error
+void test_negative_latency_clamps_to_zero() {
+    syncTo(100000, 5000);
+    link->onPacket(packet(0, 200000 + 5000 + 300), 200000);
+    TEST_ASSERT_EQUAL_UINT32(1, link->stats().latencyHistogram[0]);
+    TEST_ASSERT_EQUAL_UINT32(0, link->stats().maxLatencyUs);
+}
+
+void test_reset_stats_keeps_sync() {
+    syncTo(100000, 5000);
+    link->onPacket(packet(0, 0), 0);
+    link->onPacket(packet(4, 0), 0);
+    link->resetStats();
+
+    TEST_ASSERT_EQUAL_UINT32(0, link->stats().packetsReceived);
+    TEST_ASSERT_EQUAL_UINT32(0, link->stats().packetsLost);
+    TEST_ASSERT_TRUE(link->clockSynced());
+    link->onPacket(packet(5, 0), 0);  // Sequence carries on
+    TEST_ASSERT_EQUAL_UINT32(0, link->stats().gapEvents);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_packets_are_wire_sized);
+    RUN_TEST(test_offset_symmetric_legs);
+    RUN_TEST(test_offset_asymmetric_legs);
+    RUN_TEST(test_offset_negative);
+    RUN_TEST(test_offset_our_clock_wraps);
+    RUN_TEST(test_offset_clocks_far_apart);
+    RUN_TEST(test_rtt_filter);
+    RUN_TEST(test_start_connection_forgets_sync_and_sequence);
+    RUN_TEST(test_sequence_gaps_and_resets);
+    RUN_TEST(test_no_latency_until_synced);
+    RUN_TEST(test_latency_buckets);
+    RUN_TEST(test_negative_latency_clamps_to_zero);
+    RUN_TEST(test_reset_stats_keeps_sync);
+    return UNITY_END();
+}
@@ -0,0 +1,75 @@
+#include <unity.h>
+#include <HardwareProfile.h>
+
+// The profiles both firmwares build with
+typedef DisplayProfile<XiaoDisplayBoard, Ssd1306_128x64, GaugeStepper, ShowerGoal> Display;
+typedef GoalTable<Display> Goals;
+typedef SensingProfile<XiaoSensingBoard, YfS201, 1000> Sensing;
+
+void setUp() {}
+void tearDown() {}
+
+void test_goal_range() {
+    TEST_ASSERT_EQUAL(39, Display::goalCount);  // 5 L to 100 L in 2.5 L steps
+    TEST_ASSERT_EQUAL(10, Display::defaultGoalIndex);
+    TEST_ASSERT_EQUAL_FLOAT(30.0f, Goals::liters[Display::defaultGoalIndex]);
+    TEST_ASSERT_EQUAL_FLOAT(5.0f, Goals::liters[0]);
+    TEST_ASSERT_EQUAL_FLOAT(100.0f, Goals::liters[Display::goalCount - 1]);
+    TEST_ASSERT_EQUAL(Display::goalCount, (int)(sizeof(Goals::liters) / sizeof(Goals::liters[0])));
+}
+
+// Each table entry is the runtime formula it replaced
+void test_goal_tables_match_formulas() {
+    for (int i = 0; i < Display::goalCount; i++) {
+        float liters = 5.0f + 2.5f * i;
+        TEST_ASSERT_EQUAL_FLOAT(liters, Goals::liters[i]);
+        TEST_ASSERT_EQUAL_FLOAT(160.0f / liters, Goals::gaugeStepsPerLiter[i]);
+        TEST_ASSERT_EQUAL_FLOAT(108.0f / liters, Goals::barPixelsPerLiter[i]);
+        TEST_ASSERT_EQUAL_FLOAT(100.0f / liters, Goals::percentPerLiter[i]);
+    }
+}
+
+// A full goal lands exactly on the end of the gauge, bar and percentage
+void test_goal_reached_is_full_scale() {
+    for (int i = 0; i < Display::goalCount; i++) {
+        float liters = Goals::liters[i];
+        TEST_ASSERT_FLOAT_WITHIN(0.001, GaugeStepper::maxSteps, liters * Goals::gaugeStepsPerLiter[i]);
+        TEST_ASSERT_FLOAT_WITHIN(0.001, Display::barWidth, liters * Goals::barPixelsPerLiter[i]);
+        TEST_ASSERT_FLOAT_WITHIN(0.001, 100.0, liters * Goals::percentPerLiter[i]);
+    }
+}
+
+void test_display_layout() {
+    TEST_ASSERT_EQUAL(1024, Display::frameBytes);
+    TEST_ASSERT_EQUAL(16, Display::valueY);
+    TEST_ASSERT_EQUAL(40, Display::barY);
+    TEST_ASSERT_EQUAL(108, Display::barWidth);
+    TEST_ASSERT_EQUAL(40, Display::percentX);
+    TEST_ASSERT_EQUAL(56, Display::percentY);
+}
+
+void test_sensing_scale_factors() {
+    TEST_ASSERT_EQUAL_UINT32(1000, Sensing::sampleIntervalMs);
+    TEST_ASSERT_EQUAL_UINT32(375, Sensing::maxPulsesPerSample);  // 50 L/min at 7.5 Hz per L/min
+    TEST_ASSERT_EQUAL_FLOAT(1.0f / 450.0f, Sensing::litersPerPulse);
+    TEST_ASSERT_EQUAL_FLOAT(1.0f / 7.5f, Sensing::flowLpmPerPulse);
+}
+
+// The pulse cap and flow scale follow the sample interval
+void test_sensing_other_interval() {
+    typedef SensingProfile<XiaoSensingBoard, YfS201, 500> HalfSecond;
+    TEST_ASSERT_EQUAL_UINT32(187, HalfSecond::maxPulsesPerSample);
+    TEST_ASSERT_EQUAL_FLOAT(2.0f / 7.5f, HalfSecond::flowLpmPerPulse);
+    TEST_ASSERT_EQUAL_FLOAT(Sensing::litersPerPulse, HalfSecond::litersPerPulse);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_goal_range);
+    RUN_TEST(test_goal_tables_match_formulas);
+    RUN_TEST(test_goal_reached_is_full_scale);
+    RUN_TEST(test_display_layout);
+    RUN_TEST(test_sensing_scale_factors);
+    RUN_TEST(test_sensing_other_interval);
+    return UNITY_END();
+}
@@ -0,0 +1,246 @@
+#include <unity.h>
+#include <Scheduler.h>
+
+// Fake clock, moved by the tests and by the tasks themselves
+static uint32_t fakeMicros = 0;
+static uint32_t fakeClock() { return fakeMicros; }
+
+static Scheduler* scheduler;
+
+// Order the tasks ran in, by letter
+static char order[64];
+static int orderLength = 0;
+static void record(char c) {
+    if (orderLength < (int)sizeof(order) - 1) order[orderLength++] = c;
+    order[orderLength] = '\0';
+}
+
+static void taskA() { record('a'); }
+static void taskB() { record('b'); }
+static void taskC() { record('c'); }
+
+// Runs for 50 ms and signals task 1 at its start
+static void slowTask() {
+    record('s');
+    scheduler->signal(1);
+    fakeMicros += 50000;
+}
+
+static int selfSignalRuns = 0;
+static void selfSignalTask() {
+    selfSignalRuns++;
+    scheduler->signal(0);
+}
+
+void setUp() {
+    fakeMicros = 1000;
+    orderLength = 0;
+    order[0] = '\0';
+    selfSignalRuns = 0;
+    scheduler = new Scheduler(fakeClock);
+}
+
+void tearDown() {
+    delete scheduler;
+}
+
+// Advance to each timer in turn until endUs, running what is ready
+static void runUntil(uint32_t endUs) {
+    scheduler->runReady();
+    for (;;) {
+        uint32_t wait = scheduler->timeUntilNextUs();
+        if (wait == Scheduler::NEVER || wait > endUs - fakeMicros) break;
+        fakeMicros += wait;
+        scheduler->runReady();
+    }
+    fakeMicros = endUs;
+}
+
+void test_idle_and_ready() {
+    int a = scheduler->addEventTask("a", taskA);
+    TEST_ASSERT_EQUAL_UINT32(Scheduler::NEVER, scheduler->timeUntilNextUs());
+
+    scheduler->signal(a);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler->timeUntilNextUs());
+    scheduler->runReady();
+    TEST_ASSERT_EQUAL_STRING("a", order);
+    TEST_ASSERT_EQUAL_UINT32(Scheduler::NEVER, scheduler->timeUntilNextUs());
+}
+
+void test_signals_coalesce() {
+    int a = scheduler->addEventTask("a", taskA);
+    scheduler->signal(a);
+    scheduler->signal(a);
+    scheduler->signal(a);
+    scheduler->runReady();
+    TEST_ASSERT_EQUAL_STRING("a", order);
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler->stats(a).runs);
+}
+
+void test_earliest_deadline_first() {
+    int a = scheduler->addEventTask("a", taskA, 50);
+    int b = scheduler->addEventTask("b", taskB, 10);
+    int c = scheduler->addEventTask("c", taskC, 30);
+    scheduler->signal(a);
+    scheduler->signal(b);
+    scheduler->signal(c);
+    scheduler->runReady();
+    TEST_ASSERT_EQUAL_STRING("bca", order);
+}
+
+// A signal that has waited ranks by when it was raised, not when seen
+void test_old_signal_ranks_ahead_of_fresh_one() {
+    int a = scheduler->addEventTask("a", taskA, 100);
+    int b = scheduler->addEventTask("b", taskB, 20);
+    scheduler->signal(a);  // Deadline 1000 + 100 ms
+    fakeMicros += 90000;
+    scheduler->signal(b);  // Deadline 91000 + 20 ms
+    fakeMicros += 5000;
+    scheduler->runReady();
+    TEST_ASSERT_EQUAL_STRING("ab", order);
+}
+
+void test_period_does_not_drift() {
+    int a = scheduler->addTask("a", taskA, 10);
+    scheduler->runReady();  // First run is immediate
+
+    // Run each release 2 ms late; the next release stays on the grid
+    for (int i = 1; i <= 5; i++) {
+        fakeMicros = 1000 + i * 10000 + 2000;
+        scheduler->runReady();
+        TEST_ASSERT_EQUAL_UINT32(8000, scheduler->timeUntilNextUs());
+    }
+    TEST_ASSERT_EQUAL_UINT32(6, scheduler->stats(a).runs);
+    TEST_ASSERT_EQUAL_UINT32(2000, scheduler->stats(a).maxLateUs);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler->stats(a).deadlineMisses);
+}
+
+// After a long stall a periodic task runs once, not once per missed period
+void test_no_burst_after_stall() {
+    int a = scheduler->addTask("a", taskA, 10);
+    scheduler->runReady();
+    fakeMicros += 55000;
+    scheduler->runReady();
+
+    TEST_ASSERT_EQUAL_UINT32(2, scheduler->stats(a).runs);
+    TEST_ASSERT_EQUAL_UINT32(10000, scheduler->timeUntilNextUs());
+    TEST_ASSERT_EQUAL_UINT32(45000, scheduler->stats(a).maxLateUs);
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler->stats(a).deadlineMisses);
+}
+
+void test_run_after_moves_periodic_release() {
+    int a = scheduler->addTask("a", taskA, 100);
+    scheduler->runReady();
+    scheduler->runAfter(a, 30);
+    TEST_ASSERT_EQUAL_UINT32(30000, scheduler->timeUntilNextUs());
+
+    runUntil(fakeMicros + 30000);
+    TEST_ASSERT_EQUAL_UINT32(2, scheduler->stats(a).runs);
+    TEST_ASSERT_EQUAL_UINT32(100000, scheduler->timeUntilNextUs());  // Period resumes from there
+}
+
+void test_run_after_on_event_task_is_one_shot() {
+    int a = scheduler->addEventTask("a", taskA);
+    scheduler->runAfter(a, 5);
+    runUntil(fakeMicros + 100000);
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler->stats(a).runs);
+    TEST_ASSERT_EQUAL_UINT32(Scheduler::NEVER, scheduler->timeUntilNextUs());
+}
+
+void test_cancel_stops_until_run_after() {
+    int a = scheduler->addTask("a", taskA, 10);
+    scheduler->runReady();
+    scheduler->cancel(a);
+    runUntil(fakeMicros + 100000);
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler->stats(a).runs);
+
+    scheduler->signal(a);  // Signals still work while cancelled
+    scheduler->runReady();
+    TEST_ASSERT_EQUAL_UINT32(2, scheduler->stats(a).runs);
+    TEST_ASSERT_EQUAL_UINT32(Scheduler::NEVER, scheduler->timeUntilNextUs());
+
+    scheduler->runAfter(a, 10);
+    runUntil(fakeMicros + 35000);
+    TEST_ASSERT_EQUAL_UINT32(5, scheduler->stats(a).runs);
+}
+
+// A task that keeps signaling itself can't keep runReady() from returning
+void test_run_ready_is_bounded() {
+    int t = scheduler->addEventTask("self", selfSignalTask);
+    scheduler->signal(t);
+    scheduler->runReady();
+    TEST_ASSERT_EQUAL(2 * SCHEDULER_MAX_TASKS, selfSignalRuns);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler->timeUntilNextUs());
+}
+
+void test_task_table_full() {
+    for (int i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+        TEST_ASSERT_EQUAL(i, scheduler->addEventTask("a", taskA));
+    }
+    TEST_ASSERT_EQUAL(Scheduler::NO_TASK, scheduler->addEventTask("a", taskA));
+    scheduler->signal(Scheduler::NO_TASK);  // Ignored
+    scheduler->signal(SCHEDULER_MAX_TASKS);
+    TEST_ASSERT_EQUAL_UINT32(Scheduler::NEVER, scheduler->timeUntilNextUs());
+}
+
+void test_micros_wrap() {
+    fakeMicros = 0xFFFFFFFF - 15000;
+    int a = scheduler->addTask("a", taskA, 10);
+    scheduler->runReady();
+    TEST_ASSERT_EQUAL_UINT32(10000, scheduler->timeUntilNextUs());
+
+    runUntil(fakeMicros + 40000);  // Crosses the wrap
+    TEST_ASSERT_EQUAL_UINT32(5, scheduler->stats(a).runs);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler->stats(a).maxLateUs);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler->stats(a).deadlineMisses);
+    TEST_ASSERT_EQUAL_UINT32(10000, scheduler->timeUntilNextUs());
+}
+
+// Lateness counts from the signal, so a task held up by a slow one shows it
+void test_signal_lateness_and_deadline_miss() {
+    int slow = scheduler->addEventTask("slow", slowTask, 100);
+    int button = scheduler->addEventTask("button", taskB, 10);
+    TEST_ASSERT_EQUAL(1, button);
+
+    scheduler->signal(slow);
+    scheduler->runReady();
+    TEST_ASSERT_EQUAL_STRING("sb", order);
+    TEST_ASSERT_EQUAL_UINT32(50000, scheduler->stats(button).maxLateUs);
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler->stats(button).deadlineMisses);
+    TEST_ASSERT_EQUAL_UINT32(50000, scheduler->stats(slow).maxRunUs);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler->stats(slow).deadlineMisses);
+
+    // Handled in time, no new miss
+    scheduler->signal(button);
+    fakeMicros += 4000;
+    scheduler->runReady();
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler->stats(button).deadlineMisses);
+    TEST_ASSERT_EQUAL_UINT32(2, scheduler->stats(button).runs);
+}
+
+void test_reset_stats_keeps_names() {
+    int a = scheduler->addTask("a", taskA, 10);
+    scheduler->runReady();
+    scheduler->resetStats();
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler->stats(a).runs);
+    TEST_ASSERT_EQUAL_STRING("a", scheduler->stats(a).name);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_idle_and_ready);
+    RUN_TEST(test_signals_coalesce);
+    RUN_TEST(test_earliest_deadline_first);
+    RUN_TEST(test_old_signal_ranks_ahead_of_fresh_one);
+    RUN_TEST(test_period_does_not_drift);
+    RUN_TEST(test_no_burst_after_stall);
+    RUN_TEST(test_run_after_moves_periodic_release);
+    RUN_TEST(test_run_after_on_event_task_is_one_shot);
+    RUN_TEST(test_cancel_stops_until_run_after);
+    RUN_TEST(test_run_ready_is_bounded);
+    RUN_TEST(test_task_table_full);
+    RUN_TEST(test_micros_wrap);
+    RUN_TEST(test_signal_lateness_and_deadline_miss);
+    RUN_TEST(test_reset_stats_keeps_names);
+    return UNITY_END();
+}
@@ -0,0 +1,220 @@
+#include <unity.h>
+#include <new>
+#include <LoopScheduler.h>
+#include <Button.h>
+#include <FrameFlusher.h>
+#include <HardwareProfile.h>
+#include <LinkStats.h>
+
+// The firmware itself, built against the stand-ins in test/stubs
+#include "../../src/main.cpp"
+
+// **Allocation Counting**
+// Every C++ allocation goes through here. Guarded allocations are the ones
+// HEAP_ASSERT_NO_ALLOC would abort on.
+static uint32_t liveAllocs = 0;
+static size_t liveBytes = 0;
+static uint32_t guardedAllocs = 0;
+
+union AllocHeader {
+    size_t size;
+    max_align_t align;
+};
+
+static void* countedAlloc(size_t size) {
+    if (heapLocked && heapGuardDepth > 0) guardedAllocs++;
+    AllocHeader* h = (AllocHeader*)malloc(sizeof(AllocHeader) + size);
+    if (h == NULL) return NULL;
+    h->size = size;
+    liveAllocs++;
+    liveBytes += size;
+    return h + 1;
+}
+
+static void countedFree(void* p) {
+    if (p == NULL) return;
+    AllocHeader* h = (AllocHeader*)p - 1;
+    liveAllocs--;
+    liveBytes -= h->size;
+    free(h);
+}
+
+void* operator new(size_t size) {
+    void* p = countedAlloc(size);
+    if (p == NULL) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void operator delete(void* p) noexcept { countedFree(p); }
+void operator delete[](void* p) noexcept { countedFree(p); }
+void operator delete(void* p, size_t) noexcept { countedFree(p); }
+void operator delete[](void* p, size_t) noexcept { countedFree(p); }
+
+// **Stub Globals**
+uint32_t fakeMicros = 0;
+uint32_t taskNotifications = 0;
+HardwareSerial Serial;
+EspClass ESP;
+TwoWire Wire;
+int BLEClient::instances = 0;
+
+static const char* const sensorCharacteristics[] = { Ble::dataUuid(), Ble::syncUuid() };
+BLEPeer blePeer = { Ble::serviceUuid(), sensorCharacteristics, 2, false };
+
+static const BLEAdvertisedDevice sensor("Sensing_Device", BLEUUID(Ble::serviceUuid()));
+static const int CYCLES = 5000;
+static uint32_t packetSeq = 0;
+
+// Run the loop until nothing is ready, advancing the clock to each timer
+static void runFor(uint32_t ms) {
+    uint32_t end = fakeMicros + ms * 1000;
+    for (;;) {
+        loop();
+        uint32_t wait = scheduler.timeUntilNextUs();
+        if (wait == Scheduler::NEVER || wait > end - fakeMicros) break;
+        fakeMicros += wait ? wait : 1;
+    }
+    fakeMicros = end;
+    loop();
+}
+
+// Every test starts from a booted device, whichever runs first
+void setUp() {
+    static bool booted = false;
+    if (booted) return;
+    booted = true;
+    setup();
+    runFor(10);
+}
+
+void tearDown() {}
+
+// The connect task isn't started on the host; run its attempt when kicked
+static void runConnectTask() {
+    if (connectBusy) runConnect();
+}
+
+static BLERemoteCharacteristic* sensorCharacteristic(const char* uuid) {
+    BLERemoteService* service = pClient->getService(serviceUUID);
+    return service == NULL ? NULL : service->getCharacteristic(BLEUUID(uuid));
+}
+
+// Scan match, connect, a clock sync, a few packets and a button press,
+// then the link drops
+static void connectCycle() {
+    BLEDevice::getScan()->advertise(sensor);
+    loop();
+    runConnectTask();
+    runFor(20);
+
+    BLERemoteCharacteristic* sync = sensorCharacteristic(Ble::syncUuid());
+    if (sync != NULL && sync->lastWriteLength() == sizeof(SyncPacket)) {
+        SyncPacket reply;
+        memcpy(&reply, sync->lastWrite(), sizeof(reply));
+        reply.t2 = reply.t1 + 3000;
+        reply.t3 = reply.t2 + 500;
+        fakeMicros += 6000;
+        sync->notify(&reply, sizeof(reply));
+    }
+
+    BLERemoteCharacteristic* data = sensorCharacteristic(Ble::dataUuid());
+    for (int i = 0; data != NULL && i < 3; i++) {
+        DataPacket packet = { packetSeq++, fakeMicros, 0.5f * i };
+        data->notify(&packet, sizeof(packet));
+        runFor(40);
+    }
+
+    buttonUp.edge(true, micros());
+    scheduler.signalFromTask(buttonTask);
+    runFor(30);
+    buttonUp.edge(false, micros());
+    runFor(30);
+
+    pClient->disconnect();
+    runFor(20);
+}
+
+void test_setup_creates_one_client() {
+    TEST_ASSERT_TRUE(heapLocked);
+    TEST_ASSERT_EQUAL(1, BLEClient::instances);
+    TEST_ASSERT_TRUE(scanning);
+}
+
+// Console input runs the console task; nothing polls for it
+void test_console_runs_on_input() {
+    uint32_t runs = scheduler.stats(consoleTask).runs;
+    runFor(1000);
+    TEST_ASSERT_EQUAL_UINT32(runs, scheduler.stats(consoleTask).runs);
+
+    Serial.receive("tfh");
+    runFor(1);
+    TEST_ASSERT_EQUAL_UINT32(runs + 1, scheduler.stats(consoleTask).runs);
+    TEST_ASSERT_EQUAL(0, Serial.available());
+}
+
+void test_connect_cycle() {
+    uint32_t connectsBefore = connectCount;
+    uint32_t scansBefore = BLEDevice::getScan()->starts;
+    connectCycle();
+
+    TEST_ASSERT_EQUAL_UINT32(connectsBefore + 1, connectCount);
+    TEST_ASSERT_TRUE(linkStats.clockSynced());
+    TEST_ASSERT_EQUAL_UINT32(0, linkStats.stats().packetsLost);
+    TEST_ASSERT_FALSE(connected);
+    TEST_ASSERT_TRUE(scanning);  // Scanning again after the drop
+    TEST_ASSERT_EQUAL_UINT32(scansBefore + 1, BLEDevice::getScan()->starts);
+}
+
+// Thousands of connect/disconnect cycles leave the heap where it started
+void test_soak_connect_disconnect() {
+    connectCycle();  // Warm up lazily grown buffers
+    uint32_t allocsBefore = liveAllocs;
+    size_t bytesBefore = liveBytes;
+    uint32_t connectsBefore = connectCount;
+
+    for (int i = 0; i < CYCLES; i++) {
+        connectCycle();
+        if (liveAllocs != allocsBefore) break;
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(connectsBefore + CYCLES, connectCount);
+    TEST_ASSERT_EQUAL_UINT32(allocsBefore, liveAllocs);
+    TEST_ASSERT_EQUAL_UINT32(bytesBefore, liveBytes);
+    TEST_ASSERT_EQUAL(1, BLEClient::instances);
+    TEST_ASSERT_EQUAL_UINT32(0, guardedAllocs);
+}
+
+// A refused connect goes back to scanning without leaking either
+void test_soak_refused_connect() {
+    uint32_t allocsBefore = liveAllocs;
+    size_t bytesBefore = liveBytes;
+    uint32_t connectsBefore = connectCount;
+
+    blePeer.refuseConnect = true;
+    for (int i = 0; i < CYCLES; i++) {
+        BLEDevice::getScan()->advertise(sensor);
+        loop();
+        runConnectTask();
+        runFor(20);
+        if (!scanning) break;
+    }
+    blePeer.refuseConnect = false;
+
+    TEST_ASSERT_EQUAL_UINT32(connectsBefore, connectCount);
+    TEST_ASSERT_TRUE(scanning);
+    TEST_ASSERT_EQUAL_UINT32(allocsBefore, liveAllocs);
+    TEST_ASSERT_EQUAL_UINT32(bytesBefore, liveBytes);
+    TEST_ASSERT_EQUAL_UINT32(0, guardedAllocs);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_setup_creates_one_client);
+    RUN_TEST(test_console_runs_on_input);
+    RUN_TEST(test_connect_cycle);
+    RUN_TEST(test_soak_connect_disconnect);
+    RUN_TEST(test_soak_refused_connect);
+    return UNITY_END();
+}
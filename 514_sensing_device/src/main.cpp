@@ -3,26 +3,33 @@
 #include <BLEServer.h>
 #include <BLEUtils.h>
 #include <BLE2902.h>
+#include <LoopScheduler.h>
+#include <HardwareProfile.h>
 
-#define FLOW_SENSOR_PIN 2  // Directly connected to YF-S201 signal pin
+// Hardware Profile - pick the parts for this build variant here
+typedef SensingProfile<XiaoSensingBoard, YfS201, 1000> Profile;  // Sample every second
+typedef Profile::board Board;
+typedef WaterTrackerBle Ble;
 
 // BLE Server Variables
 BLEServer* pServer = NULL;
 BLECharacteristic* pCharacteristic = NULL;
+BLECharacteristic* pSyncCharacteristic = NULL;
 bool deviceConnected = false;
-bool oldDeviceConnected = false;
-unsigned long previousMillis = 0;
-const long interval = 1000;  // BLE update interval (1 second)
+bool advertisePending = false;  // Waiting to restart advertising
 
 // Flow Sensor Variables
 volatile uint16_t pulseCount = 0;
 float flowRate = 0.0;
 float totalLiters = 0.0;
-unsigned long lastTime = 0;
+uint32_t sequenceNumber = 0;  // Increments on every BLE update
 
-// BLE UUIDs
-#define SERVICE_UUID        "6ffd810a-1f60-43df-aa2f-cb68a815285f"  // Unique service ID
-#define CHARACTERISTIC_UUID "7ca0eada-bb21-4d31-8c72-e52221ea4409"  // Unique characteristic ID
+// Task Scheduler
+LoopScheduler scheduler;
+
+int sampleTask = Scheduler::NO_TASK;
+int advertiseTask = Scheduler::NO_TASK;
+int consoleTask = Scheduler::NO_TASK;
 
 // Interrupt Service Routine (ISR) for Flow Sensor
 void IRAM_ATTR countPulse() {
@@ -37,16 +44,103 @@ class MyServerCallbacks : public BLEServerCallbacks {
 
     void onDisconnect(BLEServer* pServer) {
         deviceConnected = false;
+        scheduler.signalFromTask(advertiseTask);
+    }
+};
+
+// Clock Sync Callbacks - stamp the display's request and send it back
+class MySyncCallbacks : public BLECharacteristicCallbacks {
+    void onWrite(BLECharacteristic* pChar) {
+        uint32_t receiveTime = micros();
+        if (pChar->getLength() != sizeof(SyncPacket)) {
+            return;
+        }
+
+        SyncPacket packet;
+        memcpy(&packet, pChar->getData(), sizeof(packet));
+        packet.t2 = receiveTime;
+        packet.t3 = micros();
+        pChar->setValue((uint8_t*)&packet, sizeof(packet));
+        pChar->notify();
     }
 };
 
+// Sample Task - convert pulses to flow and send the total every second
+void sampleFlow() {
+    detachInterrupt(Board::flowSensorPin);
+    uint16_t pulses = pulseCount;
+
+    // Scale factors come from the sensor's K-factor at compile time
+    if (pulses > Profile::maxPulsesPerSample) {  // 🚨 Limit max realistic flow rate
+        Serial.println("⚠️ Warning: Unrealistic flow rate detected!");
+        pulses = 0;  // Ignore this reading
+    }
+    flowRate = pulses * Profile::flowLpmPerPulse;     // L/min over this sample
+    totalLiters += pulses * Profile::litersPerPulse;  // Calculate total volume (Liters)
+
+    Serial.print("Flow Rate: ");
+    Serial.print(flowRate);
+    Serial.print(" L/min, Total Accumulated: ");
+    Serial.print(totalLiters);
+    Serial.println(" L");
+
+    pulseCount = 0;  // Reset count
+
+    attachInterrupt(digitalPinToInterrupt(Board::flowSensorPin), countPulse, FALLING);
+
+    // Send data via BLE if connected
+    if (deviceConnected) {
+        DataPacket packet;
+        packet.seq = sequenceNumber++;
+        packet.totalLiters = totalLiters;
+        packet.timestamp = micros();  // Stamp as late as possible
+
+        Serial.print("Sending BLE Data: seq ");
+        Serial.print(packet.seq);
+        Serial.print(", ");
+        Serial.print(packet.totalLiters);
+        Serial.println(" L");
+
+        pCharacteristic->setValue((uint8_t*)&packet, sizeof(packet));
+        pCharacteristic->notify();
+    }
+}
+
+// Advertise Task - restart advertising 500 ms after a disconnect
+void restartAdvertising() {
+    if (deviceConnected) {
+        advertisePending = false;
+        return;
+    }
+
+    if (!advertisePending) {
+        advertisePending = true;
+        scheduler.runAfter(advertiseTask, 500);  // Give the stack time to clean up
+        return;
+    }
+
+    advertisePending = false;
+    pServer->startAdvertising();
+    Serial.println("Restarting BLE Advertising...");
+}
+
+// Console Task - 't' prints task statistics when serial input arrives
+void handleSerialCommands() {
+    while (Serial.available()) {
+        if (Serial.read() == 't') {
+            Serial.println("Task statistics:");
+            scheduler.printStats(Serial);
+        }
+    }
+}
+
 void setup() {
     Serial.begin(115200);
     delay(3000); 
     Serial.println("Initializing BLE...");
     // Setup Flow Sensor
-    pinMode(FLOW_SENSOR_PIN, INPUT_PULLUP);
-    attachInterrupt(digitalPinToInterrupt(FLOW_SENSOR_PIN), countPulse, FALLING);  // Detect pulses
+    pinMode(Board::flowSensorPin, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(Board::flowSensorPin), countPulse, FALLING);  // Detect pulses
 
     // Setup BLE Server
     BLEDevice::init("YF-S201_Sensor");
@@ -54,19 +148,28 @@ void setup() {
     pServer = BLEDevice::createServer();
     pServer->setCallbacks(new MyServerCallbacks());
 
-    BLEService *pService = pServer->createService(SERVICE_UUID);
+    BLEService *pService = pServer->createService(Ble::serviceUuid());
     pCharacteristic = pService->createCharacteristic(
-        CHARACTERISTIC_UUID,
+        Ble::dataUuid(),
         BLECharacteristic::PROPERTY_READ |
         BLECharacteristic::PROPERTY_NOTIFY
     );
     pCharacteristic->addDescriptor(new BLE2902());
 
+    pSyncCharacteristic = pService->createCharacteristic(
+        Ble::syncUuid(),
+        BLECharacteristic::PROPERTY_WRITE |
+        BLECharacteristic::PROPERTY_WRITE_NR |
+        BLECharacteristic::PROPERTY_NOTIFY
+    );
+    pSyncCharacteristic->addDescriptor(new BLE2902());
+    pSyncCharacteristic->setCallbacks(new MySyncCallbacks());
+
     pService->start();
 
     // Start advertising BLE service
     BLEAdvertising *pAdvertising = BLEDevice::getAdvertising();
-    pAdvertising->addServiceUUID(SERVICE_UUID);
+    pAdvertising->addServiceUUID(Ble::serviceUuid());
     pAdvertising->setScanResponse(true);
     pAdvertising->setMinPreferred(0x06);
     pAdvertising->setMinPreferred(0x12);
@@ -74,60 +177,17 @@ void setup() {
     Serial.println("BLE is now advertising...");
     
     Serial.println("BLE Server Started. Waiting for connections...");
+
+    // Register tasks (setup() runs on the loop task)
+    scheduler.begin();
+    sampleTask = scheduler.addTask("sample", sampleFlow, Profile::sampleIntervalMs);
+    advertiseTask = scheduler.addEventTask("advertise", restartAdvertising, 1000);
+    consoleTask = scheduler.addEventTask("console", handleSerialCommands);
+    scheduler.signalOnSerialInput(consoleTask);
+    scheduler.runAfter(sampleTask, Profile::sampleIntervalMs);  // First sample covers a full interval
 }
 
+// Run ready tasks, then sleep until the next deadline or a signal
 void loop() {
-    unsigned long currentTime = millis();
-
-    if (currentTime - lastTime >= 1000) {  // Every second
-        detachInterrupt(FLOW_SENSOR_PIN);
-
-        // Convert pulse count to flow rate in L/min
-        flowRate = (pulseCount / 7.5);
-        if (flowRate > 50.0) {  // 🚨 Limit max realistic flow rate
-            Serial.println("⚠️ Warning: Unrealistic flow rate detected!");
-            flowRate = 0.0;  // Ignore this reading
-        }
-        // Calculate total volume (Liters)
-        totalLiters += (flowRate / 60.0); // Convert L/min to liters per second
-
-        Serial.print("Flow Rate: ");
-        Serial.print(flowRate);
-        Serial.print(" L/min, Total Accumulated: ");
-        Serial.print(totalLiters);
-        Serial.println(" L");
-
-        pulseCount = 0;  // Reset count
-        lastTime = currentTime;
-
-        attachInterrupt(digitalPinToInterrupt(FLOW_SENSOR_PIN), countPulse, FALLING);
-
-        // Send data via BLE if connected
-        if (deviceConnected) {
-            char buffer[20];
-            memset(buffer, 0, sizeof(buffer)); // Clear buffer to prevent corruption
-            snprintf(buffer, sizeof(buffer), "%.2f", totalLiters);
-
-            Serial.print("Sending BLE Data: ");
-            Serial.println(buffer);  // Debug print to confirm full message is sent
-
-            pCharacteristic->setValue(buffer);
-            pCharacteristic->notify();
-        }
-    }
-
-    // Manage BLE connection status
-    if (!deviceConnected && oldDeviceConnected) {
-        delay(500);
-        pServer->startAdvertising();
-        Serial.println("Restarting BLE Advertising...");
-        oldDeviceConnected = deviceConnected;
-    }
-
-    if (deviceConnected && !oldDeviceConnected) {
-        oldDeviceConnected = deviceConnected;
-    }
-
-    delay(1000);
+    scheduler.runOnce();
 }
-
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <stdint.h>
+
+// **Hardware Profiles**
+// Pins, panel geometry, gauge range, goal settings, sensor constants, BLE
+// UUIDs and packets for both devices. Each firmware picks its parts with one
+// typedef; everything derived from them (scale factors, layout, the goal
+// lookup tables) is computed by the compiler. No Arduino headers, so the
+// same profiles build for the C3 and for a native host.
+
+// **BLE Service** - shared by the sensing and display devices
+struct WaterTrackerBle {
+    static constexpr const char* serviceUuid() { return "6ffd810a-1f60-43df-aa2f-cb68a815285f"; }
+    static constexpr const char* dataUuid() { return "7ca0eada-bb21-4d31-8c72-e52221ea4409"; }
+    static constexpr const char* syncUuid() { return "f9b923e3-f02a-4784-a12c-6f25ebb787d1"; }
+};
+
+// **BLE Packets** - sent little endian, both devices are ESP32-C3s
+struct __attribute__((packed)) DataPacket {
+    uint32_t seq;        // Sequence number
+    uint32_t timestamp;  // Sensor micros() when sent
+    float totalLiters;   // Total accumulated volume
+};
+static_assert(sizeof(DataPacket) == 12, "DataPacket is the data characteristic's wire format");
+
+// Clock sync: the display writes t1, the sensor fills in t2/t3 and notifies
+struct __attribute__((packed)) SyncPacket {
+    uint32_t t1;  // Display micros() when the request was sent
+    uint32_t t2;  // Sensor micros() when the request was received
+    uint32_t t3;  // Sensor micros() when the reply was sent
+};
+static_assert(sizeof(SyncPacket) == 12, "SyncPacket is the sync characteristic's wire format");
+
+// **Display Device Parts**
+// XIAO ESP32C3 on the display PCB
+struct XiaoDisplayBoard {
+    static constexpr uint8_t sdaPin = 6;
+    static constexpr uint8_t sclPin = 7;
+    static constexpr uint8_t motorPin1 = 0;
+    static constexpr uint8_t motorPin2 = 1;
+    static constexpr uint8_t motorPin3 = 2;
+    static constexpr uint8_t motorPin4 = 3;
+    static constexpr uint8_t buttonUpPin = 8;
+    static constexpr uint8_t buttonDownPin = 9;
+    static constexpr uint8_t ledPin = 10;
+};
+
+// 128x64 SSD1306 OLED on I2C
+struct Ssd1306_128x64 {
+    static constexpr int16_t width = 128;
+    static constexpr int16_t height = 64;
+    static constexpr int8_t resetPin = -1;
+    static constexpr uint8_t i2cAddress = 0x3C;
+    static constexpr uint32_t i2cClock = 400000;  // Fast mode, most modules also run at 800k-1M
+};
+
+// Automotive gauge stepper driving the needle
+struct GaugeStepper {
+    static constexpr int minSteps = 0;
+    static constexpr int maxSteps = 160;
+    static constexpr int homeSteps = 170;           // Backward steps to hit the end stop
+    static constexpr uint32_t phaseIntervalMs = 10; // Time per coil phase
+};
+
+// Weekly goal range and button increment, in deciliters to stay exact
+struct ShowerGoal {
+    static constexpr int minDeciliters = 50;
+    static constexpr int maxDeciliters = 1000;
+    static constexpr int incrementDeciliters = 25;
+    static constexpr int defaultDeciliters = 300;
+};
+
+template <class Board, class Panel, class Gauge, class Goal>
+struct DisplayProfile {
+    typedef Board board;
+    typedef Panel panel;
+    typedef Gauge gauge;
+
+    static_assert(Panel::height % 8 == 0, "SSD1306 pages are 8 rows");
+    static_assert(Gauge::homeSteps >= Gauge::maxSteps - Gauge::minSteps, "Homing must cover the full sweep");
+    static_assert(Goal::minDeciliters > 0, "Goal is used as a divisor");
+    static_assert((Goal::maxDeciliters - Goal::minDeciliters) % Goal::incrementDeciliters == 0,
+                  "Goal range must be a whole number of increments");
+    static_assert((Goal::defaultDeciliters - Goal::minDeciliters) % Goal::incrementDeciliters == 0,
+                  "Default goal must be reachable with the buttons");
+
+    // Frame buffer
+    static constexpr int frameBytes = Panel::width * Panel::height / 8;
+
+    // Layout, scaled from the 128x64 design
+    static constexpr int16_t valueX = 5;
+    static constexpr int16_t valueY = Panel::height / 4;
+    static constexpr int16_t barX = 10;
+    static constexpr int16_t barY = Panel::height * 5 / 8;
+    static constexpr int16_t barWidth = Panel::width - 2 * barX;
+    static constexpr int16_t barHeight = 15;
+    static constexpr int16_t percentX = Panel::width * 5 / 16;
+    static constexpr int16_t percentY = Panel::height - 8;
+    static_assert(barY + barHeight <= percentY, "Progress bar overlaps the percentage");
+
+    // Goals, indexed from the minimum in button increments
+    static constexpr int goalCount = (Goal::maxDeciliters - Goal::minDeciliters) / Goal::incrementDeciliters + 1;
+    static constexpr int defaultGoalIndex = (Goal::defaultDeciliters - Goal::minDeciliters) / Goal::incrementDeciliters;
+
+    static constexpr float goalLiters(int index) {
+        return (Goal::minDeciliters + index * Goal::incrementDeciliters) / 10.0f;
+    }
+    static constexpr float gaugeStepsPerLiter(int index) {
+        return (Gauge::maxSteps - Gauge::minSteps) / goalLiters(index);
+    }
+    static constexpr float barPixelsPerLiter(int index) {
+        return barWidth / goalLiters(index);
+    }
+    static constexpr float percentPerLiter(int index) {
+        return 100.0f / goalLiters(index);
+    }
+};
+
+// **Sensing Device Parts**
+// XIAO ESP32C3 on the sensing PCB
+struct XiaoSensingBoard {
+    static constexpr uint8_t flowSensorPin = 2;  // YF-S201 signal
+};
+
+// YF-S201 hall effect flow sensor
+struct YfS201 {
+    static constexpr float kFactor = 7.5f;      // Pulse frequency (Hz) per L/min
+    static constexpr float maxFlowLpm = 50.0f;  // Anything above is noise
+};
+
+template <class Board, class Sensor, uint32_t SampleMs>
+struct SensingProfile {
+    typedef Board board;
+
+    static_assert(SampleMs > 0, "Sample interval must be positive");
+
+    static constexpr uint32_t sampleIntervalMs = SampleMs;
+
+    // Flow over one sample interval, and volume per pulse
+    static constexpr float flowLpmPerPulse = 1000.0f / (Sensor::kFactor * SampleMs);
+    static constexpr float litersPerPulse = 1.0f / (Sensor::kFactor * 60.0f);
+    static constexpr uint32_t maxPulsesPerSample = (uint32_t)(Sensor::maxFlowLpm * Sensor::kFactor * SampleMs / 1000.0f);
+};
+
+// **Compile-Time Goal Tables**
+// Per-goal scale factors so the gauge and progress bar need one multiply
+// instead of map()/division at runtime. Use as GoalTable<Profile>.
+template <int... I> struct Indices {};
+template <int N, int... I> struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+template <int... I> struct MakeIndices<0, I...> { typedef Indices<I...> type; };
+
+template <class Profile, class Seq = typename MakeIndices<Profile::goalCount>::type>
+struct GoalTable;
+
+template <class Profile, int... I>
+struct GoalTable<Profile, Indices<I...> > {
+    static constexpr float liters[sizeof...(I)] = { Profile::goalLiters(I)... };
+    static constexpr float gaugeStepsPerLiter[sizeof...(I)] = { Profile::gaugeStepsPerLiter(I)... };
+    static constexpr float barPixelsPerLiter[sizeof...(I)] = { Profile::barPixelsPerLiter(I)... };
+    static constexpr float percentPerLiter[sizeof...(I)] = { Profile::percentPerLiter(I)... };
+};
+
+template <class Profile, int... I>
+constexpr float GoalTable<Profile, Indices<I...> >::liters[sizeof...(I)];
+template <class Profile, int... I>
+constexpr float GoalTable<Profile, Indices<I...> >::gaugeStepsPerLiter[sizeof...(I)];
+template <class Profile, int... I>
+constexpr float GoalTable<Profile, Indices<I...> >::barPixelsPerLiter[sizeof...(I)];
+template <class Profile, int... I>
+constexpr float GoalTable<Profile, Indices<I...> >::percentPerLiter[sizeof...(I)];
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <HardwareProfile.h>
+
+// **BLE Link Statistics**
+// Clock sync against the sensing device and per-packet loss and latency.
+// A sync reply carries t1/t4 on our clock and t2/t3 on the sensor's; the
+// offset is the mean of the two legs, and only replies with a round trip
+// close to the best one seen are trusted. Once synced, each data packet's
+// sensor timestamp is moved to our clock to measure its latency. No
+// Arduino headers, so the math runs the same on a host.
+class LinkStats {
+public:
+    static const int LATENCY_BUCKETS = 10;  // Last bucket holds everything above the last limit
+
+    struct Stats {
+        uint32_t packetsReceived;  // Data packets with a sequence number
+        uint32_t packetsLost;      // Sequence numbers skipped
+        uint32_t gapEvents;        // Times one or more packets were skipped
+        uint32_t sequenceResets;   // Sensor restarted its sequence
+        uint32_t maxLatencyUs;     // Worst latency seen
+        uint32_t latencyHistogram[LATENCY_BUCKETS];
+    };
+
+    LinkStats() : stats_() { startConnection(); }
+
+    // Upper limit of a latency bucket, for all but the last
+    static uint32_t bucketLimitMs(int bucket) {
+        static const uint32_t limits[LATENCY_BUCKETS - 1] = {5, 10, 20, 50, 100, 200, 500, 1000, 2000};
+        return limits[bucket];
+    }
+
+    // Forget the clock sync and sequence, the sensor may have restarted
+    void startConnection() {
+        haveLastSeq_ = false;
+        lastSeq_ = 0;
+        synced_ = false;
+        offsetUs_ = 0;
+        bestRttUs_ = UINT32_MAX;
+    }
+
+    // Sync reply received at t4; returns true if it updated the offset
+    bool onSyncReply(const SyncPacket& reply, uint32_t t4) {
+        uint32_t rtt = (t4 - reply.t1) - (reply.t3 - reply.t2);
+        // Average of the two legs, halving their difference so the sum can't
+        // overflow when the two clocks are more than 2^31 us apart
+        uint32_t d = reply.t2 - reply.t1;
+        int32_t offset = (int32_t)(d + (int32_t)((reply.t3 - t4) - d) / 2);
+
+        if (rtt < bestRttUs_) bestRttUs_ = rtt;
+        if (synced_ && rtt > 2 * bestRttUs_) return false;
+
+        offsetUs_ = offset;
+        synced_ = true;
+        return true;
+    }
+
+    // Update sequence gap counts and, once synced, the latency histogram
+    void onPacket(const DataPacket& packet, uint32_t receiveUs) {
+        stats_.packetsReceived++;
+
+        if (haveLastSeq_) {
+            if (packet.seq > lastSeq_ + 1) {
+                stats_.packetsLost += packet.seq - lastSeq_ - 1;
+                stats_.gapEvents++;
+            } else if (packet.seq <= lastSeq_) {
+                stats_.sequenceResets++;
+            }
+        }
+        lastSeq_ = packet.seq;
+        haveLastSeq_ = true;
+
+        if (!synced_) return;
+
+        // Convert the sensor timestamp to our clock before comparing
+        int32_t latencyUs = (int32_t)(receiveUs - (packet.timestamp - offsetUs_));
+        if (latencyUs < 0) latencyUs = 0;  // Within sync error
+        if ((uint32_t)latencyUs > stats_.maxLatencyUs) stats_.maxLatencyUs = latencyUs;
+
+        uint32_t latencyMs = latencyUs / 1000;
+        int bucket = 0;
+        while (bucket < LATENCY_BUCKETS - 1 && latencyMs >= bucketLimitMs(bucket)) {
+            bucket++;
+        }
+        stats_.latencyHistogram[bucket]++;
+    }
+
+    bool clockSynced() const { return synced_; }
+    int32_t clockOffsetUs() const { return offsetUs_; }  // Sensor clock minus ours
+    uint32_t bestRttUs() const { return synced_ ? bestRttUs_ : 0; }
+    const Stats& stats() const { return stats_; }
+    void resetStats() { stats_ = Stats(); }
+
+private:
+    Stats stats_;
+    bool haveLastSeq_;
+    uint32_t lastSeq_;
+    bool synced_;
+    int32_t offsetUs_;
+    uint32_t bestRttUs_;
+};
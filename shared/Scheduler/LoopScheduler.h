@@ -0,0 +1,92 @@
+#pragma once
+
+#include <Arduino.h>
+#include "Scheduler.h"
+
+// **Scheduler on the Arduino Loop Task**
+// The Scheduler as both firmwares run it: micros() is the clock, signals
+// from other FreeRTOS tasks and interrupts wake the loop task, and loop()
+// calls runOnce() to run what is ready and then sleep until the next timer
+// or signal. Call begin() from setup(), which runs on the loop task.
+class LoopScheduler : public Scheduler {
+public:
+    LoopScheduler() : Scheduler(clock), loopTask_(NULL) {}
+
+    static uint32_t IRAM_ATTR clock() { return micros(); }
+
+    void begin() { loopTask_ = xTaskGetCurrentTaskHandle(); }
+
+    // signal() from another FreeRTOS task, e.g. a BLE callback
+    void signalFromTask(int id) {
+        signal(id);
+        if (loopTask_ != NULL) xTaskNotifyGive(loopTask_);
+    }
+
+    // signal() from an interrupt
+    void IRAM_ATTR signalFromISR(int id) {
+        signal(id);
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(loopTask_, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+
+    // Run ready tasks, then sleep until the next deadline or a signal
+    void runOnce() {
+        runReady();
+
+        uint32_t waitUs = timeUntilNextUs();
+        if (waitUs == 0) return;
+        TickType_t ticks = waitUs == NEVER ? portMAX_DELAY : pdMS_TO_TICKS((waitUs + 999) / 1000);
+        ulTaskNotifyTake(pdTRUE, ticks);
+    }
+
+    // Signal a task whenever console input arrives, so it needs no poll.
+    // Serial is the C3's USB CDC with ARDUINO_USB_CDC_ON_BOOT, else a UART.
+    void signalOnSerialInput(int id) {
+        serialScheduler() = this;
+        serialTask() = id;
+#if ARDUINO_USB_CDC_ON_BOOT
+        Serial.onEvent(ARDUINO_HW_CDC_RX_EVENT, onSerialEvent);
+#else
+        Serial.onReceive(onSerialReceive);
+#endif
+    }
+
+    // One line per task: runs, runtime, lateness and deadline misses
+    void printStats(Print& out) const {
+        for (int i = 0; i < taskCount(); i++) {
+            const TaskStats& s = stats(i);
+            out.print("  ");
+            out.print(s.name);
+            out.print(": runs ");
+            out.print(s.runs);
+            out.print(", avg ");
+            out.print(s.runs ? (uint32_t)(s.totalRunUs / s.runs) : 0);
+            out.print(" us, max ");
+            out.print(s.maxRunUs);
+            out.print(" us, max late ");
+            out.print(s.maxLateUs);
+            out.print(" us, deadline misses ");
+            out.println(s.deadlineMisses);
+        }
+    }
+
+private:
+    // Serial callbacks carry no context, so the target lives here
+    static LoopScheduler*& serialScheduler() {
+        static LoopScheduler* scheduler = NULL;
+        return scheduler;
+    }
+    static int& serialTask() {
+        static int id = NO_TASK;
+        return id;
+    }
+
+    // Runs on the serial driver's event task
+    static void onSerialReceive() { serialScheduler()->signalFromTask(serialTask()); }
+#if ARDUINO_USB_CDC_ON_BOOT
+    static void onSerialEvent(void*, esp_event_base_t, int32_t, void*) { onSerialReceive(); }
+#endif
+
+    TaskHandle_t loopTask_;
+};
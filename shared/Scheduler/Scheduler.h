@@ -0,0 +1,190 @@
+#pragma once
+
+#include <stdint.h>
+
+// **Cooperative Task Scheduler**
+// Run-to-completion tasks that run on a period, after a one-shot delay, or
+// when signaled. Ready tasks run earliest deadline first. There is no fixed
+// tick: the caller sleeps for timeUntilNextUs() or until a signal arrives.
+// The clock is passed in, so the same code runs on the device (micros())
+// and on a host with a fake clock.
+
+#ifndef SCHEDULER_MAX_TASKS
+#define SCHEDULER_MAX_TASKS 12
+#endif
+
+class Scheduler {
+public:
+    typedef void (*TaskFunction)();
+    typedef uint32_t (*ClockFunction)();  // Free running microseconds
+
+    struct TaskStats {
+        const char* name;
+        uint32_t runs;            // Completed runs
+        uint64_t totalRunUs;      // Time spent inside the task
+        uint32_t maxRunUs;        // Longest single run
+        uint32_t maxLateUs;       // Longest wait between release and start
+        uint32_t deadlineMisses;  // Runs that finished after their deadline
+    };
+
+    static const int NO_TASK = -1;
+    static const uint32_t NEVER = 0xFFFFFFFF;
+    static const uint32_t DEFAULT_EVENT_DEADLINE_MS = 100;
+
+    explicit Scheduler(ClockFunction clock) : clock_(clock), taskCount_(0) {}
+
+    // Periodic task, first run is immediate. Deadline defaults to the period.
+    int addTask(const char* name, TaskFunction fn, uint32_t periodMs, uint32_t deadlineMs = 0) {
+        if (taskCount_ >= SCHEDULER_MAX_TASKS) return NO_TASK;
+
+        Task& t = tasks_[taskCount_];
+        t.fn = fn;
+        t.periodUs = periodMs * 1000;
+        if (deadlineMs == 0) deadlineMs = periodMs ? periodMs : DEFAULT_EVENT_DEADLINE_MS;
+        t.deadlineUs = deadlineMs * 1000;
+        t.releaseUs = clock_();
+        t.timerArmed = periodMs != 0;
+        t.signaled = false;
+        t.signalUs = 0;
+        t.stats = TaskStats();
+        t.stats.name = name;
+        return taskCount_++;
+    }
+
+    // Task that only runs when signaled or scheduled with runAfter()
+    int addEventTask(const char* name, TaskFunction fn, uint32_t deadlineMs = 0) {
+        return addTask(name, fn, 0, deadlineMs ? deadlineMs : DEFAULT_EVENT_DEADLINE_MS);
+    }
+
+    // Mark a task ready. Safe from interrupts and other threads (so the
+    // clock must be too); repeated signals before the task runs are
+    // coalesced into one run, released at the first signal.
+    void signal(int id) {
+        if (id < 0 || id >= taskCount_) return;
+        Task& t = tasks_[id];
+        if (t.signaled) return;
+        t.signalUs = clock_();
+        t.signaled = true;
+    }
+
+    // One-shot run after a delay (scheduler thread only). On a periodic
+    // task this moves the next release.
+    void runAfter(int id, uint32_t delayMs) {
+        if (id < 0 || id >= taskCount_) return;
+        tasks_[id].releaseUs = clock_() + delayMs * 1000;
+        tasks_[id].timerArmed = true;
+    }
+
+    // Stop a pending timer (periodic tasks stay stopped until runAfter())
+    void cancel(int id) {
+        if (id >= 0 && id < taskCount_) tasks_[id].timerArmed = false;
+    }
+
+    // Run every ready task, earliest deadline first
+    void runReady() {
+        // Bounded so a task that keeps re-arming itself can't starve the caller
+        for (int i = 0; i < 2 * SCHEDULER_MAX_TASKS; i++) {
+            uint32_t now = clock_();
+            int next = NO_TASK;
+            uint32_t nextDeadline = 0;
+
+            for (int id = 0; id < taskCount_; id++) {
+                const Task& t = tasks_[id];
+                if (!isReady(t, now)) continue;
+                uint32_t deadline = releaseTime(t, now) + t.deadlineUs;
+                if (next == NO_TASK || before(deadline, nextDeadline)) {
+                    next = id;
+                    nextDeadline = deadline;
+                }
+            }
+
+            if (next == NO_TASK) return;
+            runTask(tasks_[next], now);
+        }
+    }
+
+    // Microseconds until the next timer is due, 0 if a task is ready now,
+    // NEVER if nothing is scheduled
+    uint32_t timeUntilNextUs() const {
+        uint32_t now = clock_();
+        uint32_t wait = NEVER;
+        for (int id = 0; id < taskCount_; id++) {
+            const Task& t = tasks_[id];
+            if (isReady(t, now)) return 0;
+            if (t.timerArmed && t.releaseUs - now < wait) wait = t.releaseUs - now;
+        }
+        return wait;
+    }
+
+    int taskCount() const { return taskCount_; }
+    const TaskStats& stats(int id) const { return tasks_[id].stats; }
+
+    void resetStats() {
+        for (int id = 0; id < taskCount_; id++) {
+            const char* name = tasks_[id].stats.name;
+            tasks_[id].stats = TaskStats();
+            tasks_[id].stats.name = name;
+        }
+    }
+
+private:
+    struct Task {
+        TaskFunction fn;
+        uint32_t periodUs;     // 0 for event tasks
+        uint32_t deadlineUs;   // Relative to release
+        uint32_t releaseUs;    // Next timer release
+        bool timerArmed;
+        volatile bool signaled;
+        volatile uint32_t signalUs;  // When signaled went true
+        TaskStats stats;
+    };
+
+    // Wrap-safe "a is earlier than b"
+    static bool before(uint32_t a, uint32_t b) { return (int32_t)(a - b) < 0; }
+
+    static bool timerDue(const Task& t, uint32_t now) {
+        return t.timerArmed && !before(now, t.releaseUs);
+    }
+
+    static bool isReady(const Task& t, uint32_t now) {
+        return t.signaled || timerDue(t, now);
+    }
+
+    // A run serves the earlier of a due timer and a pending signal
+    static uint32_t releaseTime(const Task& t, uint32_t now) {
+        if (!t.signaled) return t.releaseUs;
+        if (timerDue(t, now) && before(t.releaseUs, t.signalUs)) return t.releaseUs;
+        return t.signalUs;
+    }
+
+    void runTask(Task& t, uint32_t now) {
+        uint32_t release = releaseTime(t, now);
+
+        if (timerDue(t, now)) {
+            if (t.periodUs == 0) {
+                t.timerArmed = false;
+            } else {
+                // Keep the period drift free, but don't burst to catch up
+                t.releaseUs += t.periodUs;
+                if (before(t.releaseUs, now)) t.releaseUs = now + t.periodUs;
+            }
+        }
+        t.signaled = false;
+
+        uint32_t start = clock_();
+        t.fn();
+        uint32_t end = clock_();
+
+        uint32_t runUs = end - start;
+        uint32_t lateUs = start - release;
+        t.stats.runs++;
+        t.stats.totalRunUs += runUs;
+        if (runUs > t.stats.maxRunUs) t.stats.maxRunUs = runUs;
+        if (lateUs > t.stats.maxLateUs) t.stats.maxLateUs = lateUs;
+        if (before(release + t.deadlineUs, end)) t.stats.deadlineMisses++;
+    }
+
+    ClockFunction clock_;
+    Task tasks_[SCHEDULER_MAX_TASKS];
+    int taskCount_;
+};